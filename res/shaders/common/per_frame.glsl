@@ -0,0 +1,5 @@
+layout(std140) uniform per_frame
+{
+    mat4 u_projection_view;
+    float u_time;
+};
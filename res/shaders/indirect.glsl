@@ -0,0 +1,47 @@
+#type vertex
+#version 440 core
+#ifdef GL_ARB_shader_draw_parameters
+#extension GL_ARB_shader_draw_parameters : enable
+#define DRAW_ID gl_DrawIDARB
+#else
+// The renderer issues every draw on its own and sets u_draw_base for each
+#define DRAW_ID 0
+#endif
+
+layout(location = 0) in vec3 a_position;
+
+out vec4 v_color;
+
+#include "common/per_frame.glsl"
+
+struct per_draw_data
+{
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer per_draw
+{
+    per_draw_data u_draws[];
+};
+
+uniform int u_draw_base;
+
+void main()
+{
+    per_draw_data draw = u_draws[u_draw_base + DRAW_ID];
+    v_color = draw.color;
+    gl_Position = u_projection_view * draw.model * vec4(a_position, 1.0);
+}
+
+#type fragment
+#version 440 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_color;
+
+void main()
+{
+    color = v_color;
+}
@@ -0,0 +1,30 @@
+#type vertex
+#version 440 core
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec2 a_texcoord;
+layout(location = 2) in vec4 a_color;
+layout(location = 3) in mat4 a_model;
+layout(location = 7) in vec4 a_instance_color;
+
+out vec4 v_color;
+
+#include "common/per_frame.glsl"
+
+void main()
+{
+    v_color = a_instance_color;
+    gl_Position = u_projection_view * a_model * vec4(a_position, 1.0);
+}
+
+#type fragment
+#version 440 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_color;
+
+void main()
+{
+    color = v_color;
+}
@@ -1,19 +1,28 @@
 #type vertex
 #version 440 core
 
+#include "common/per_frame.glsl"
+
 layout(location = 0) in vec3 a_position;
+#ifdef TEXTURED
+layout(location = 1) in vec2 a_texcoord;
+layout(location = 2) in vec4 a_color;
+
+out vec2 v_texcoord;
+#else
 layout(location = 1) in vec4 a_color;
+#endif
 
-out vec3 v_position;
 out vec4 v_color;
 
-uniform mat4 u_projection_view;
 uniform mat4 u_model;
 
 void main()
 {
     v_color = a_color;
-    v_position = a_position;
+#ifdef TEXTURED
+    v_texcoord = a_texcoord;
+#endif
     gl_Position = u_projection_view * u_model * vec4(a_position, 1.0);
 }
 
@@ -22,12 +31,20 @@ void main()
 
 layout(location = 0) out vec4 color;
 
-in vec3 v_position;
 in vec4 v_color;
+#ifdef TEXTURED
+in vec2 v_texcoord;
+
+uniform sampler2D u_texture;
+#endif
 
 uniform vec4 u_color;
 
 void main()
 {
+#ifdef TEXTURED
+    color = texture(u_texture, v_texcoord);
+#else
     color = u_color;
-}
\ No newline at end of file
+#endif
+}
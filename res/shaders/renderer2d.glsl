@@ -0,0 +1,85 @@
+#type vertex
+#version 440 core
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec4 a_color;
+layout(location = 2) in vec2 a_texcoord;
+layout(location = 3) in int a_texture_slot;
+
+out vec4 v_color;
+out vec2 v_texcoord;
+flat out int v_texture_slot;
+
+#include "common/per_frame.glsl"
+
+void main()
+{
+    v_color = a_color;
+    v_texcoord = a_texcoord;
+    v_texture_slot = a_texture_slot;
+    gl_Position = u_projection_view * vec4(a_position, 1.0);
+}
+
+#type fragment
+#version 440 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_color;
+in vec2 v_texcoord;
+flat in int v_texture_slot;
+
+// One unit less than renderer2d::max_texture_slots, the last one holds u_layers
+uniform sampler2D u_textures[31];
+uniform sampler2DArray u_layers;
+
+// Sampler arrays may only be indexed by dynamically uniform expressions and the slot
+// changes from quad to quad within a draw, so every slot samples with a constant index.
+vec4 sample_slot(int slot)
+{
+    switch(slot)
+    {
+        case  0: return texture(u_textures[ 0], v_texcoord);
+        case  1: return texture(u_textures[ 1], v_texcoord);
+        case  2: return texture(u_textures[ 2], v_texcoord);
+        case  3: return texture(u_textures[ 3], v_texcoord);
+        case  4: return texture(u_textures[ 4], v_texcoord);
+        case  5: return texture(u_textures[ 5], v_texcoord);
+        case  6: return texture(u_textures[ 6], v_texcoord);
+        case  7: return texture(u_textures[ 7], v_texcoord);
+        case  8: return texture(u_textures[ 8], v_texcoord);
+        case  9: return texture(u_textures[ 9], v_texcoord);
+        case 10: return texture(u_textures[10], v_texcoord);
+        case 11: return texture(u_textures[11], v_texcoord);
+        case 12: return texture(u_textures[12], v_texcoord);
+        case 13: return texture(u_textures[13], v_texcoord);
+        case 14: return texture(u_textures[14], v_texcoord);
+        case 15: return texture(u_textures[15], v_texcoord);
+        case 16: return texture(u_textures[16], v_texcoord);
+        case 17: return texture(u_textures[17], v_texcoord);
+        case 18: return texture(u_textures[18], v_texcoord);
+        case 19: return texture(u_textures[19], v_texcoord);
+        case 20: return texture(u_textures[20], v_texcoord);
+        case 21: return texture(u_textures[21], v_texcoord);
+        case 22: return texture(u_textures[22], v_texcoord);
+        case 23: return texture(u_textures[23], v_texcoord);
+        case 24: return texture(u_textures[24], v_texcoord);
+        case 25: return texture(u_textures[25], v_texcoord);
+        case 26: return texture(u_textures[26], v_texcoord);
+        case 27: return texture(u_textures[27], v_texcoord);
+        case 28: return texture(u_textures[28], v_texcoord);
+        case 29: return texture(u_textures[29], v_texcoord);
+        case 30: return texture(u_textures[30], v_texcoord);
+    }
+    return vec4(1.0);
+}
+
+void main()
+{
+    if(v_texture_slot < 0)
+        color = v_color;
+    else if(v_texture_slot >= 32)
+        color = texture(u_layers, vec3(v_texcoord, v_texture_slot - 32)) * v_color;
+    else
+        color = sample_slot(v_texture_slot) * v_color;
+}
@@ -1,35 +0,0 @@
-#type vertex
-#version 440 core
-
-layout(location = 0) in vec3 a_position;
-layout(location = 1) in vec2 a_texcoord;
-layout(location = 2) in vec4 a_color;
-
-out vec2 v_texcoord;
-out vec4 v_color;
-
-uniform mat4 u_projection_view;
-uniform mat4 u_model;
-
-void main()
-{
-    v_color = a_color;
-    v_texcoord = a_texcoord;
-    gl_Position = u_projection_view * u_model * vec4(a_position, 1.0);
-}
-
-#type fragment
-#version 440 core
-
-layout(location = 0) out vec4 color;
-
-in vec4 v_color;
-in vec2 v_texcoord;
-
-uniform vec4 u_color;
-uniform sampler2D u_texture;
-
-void main()
-{
-    color = texture(u_texture, v_texcoord);
-}
\ No newline at end of file
@@ -17,33 +17,55 @@ namespace engine::app {
 
     m_imgui_layer = std::make_shared<imgui_layer>(m_window);
     push_overlay(m_imgui_layer);
+    m_profiler_layer = std::make_shared<profiler_layer>();
+    push_overlay(m_profiler_layer);
     push_overlay(std::make_shared<example_layer>());
   }
 
   void application::run() 
   {
+    TRIMANA_PROFILE_THREAD("main");
     while (m_window->get_attributes().is_active) 
     {
-      /////////////////////////////////////////////////////////////////////
+      {
+        TRIMANA_PROFILE_SCOPE("application::frame");
 
-      float current_time = static_cast<float>(glfwGetTime());
-      time_steps delta_time = current_time - m_last_frame_time;
-      m_last_frame_time = current_time;
-  
-      for (std::shared_ptr<layer> layer : m_layer_stack) 
-        layer->on_update(delta_time);
+        /////////////////////////////////////////////////////////////////////
+
+        float current_time = static_cast<float>(glfwGetTime());
+        time_steps delta_time = current_time - m_last_frame_time;
+        m_last_frame_time = current_time;
+    
+        m_profiler_layer->begin_frame();
 
-      m_imgui_layer->begin();
-      {
         for (std::shared_ptr<layer> layer : m_layer_stack) 
-          layer->on_ui_updates();
-      } 
-      m_imgui_layer->end();
-
-      ///////////////////////////////////////////////////////////////////
-        
-      m_window->swap_buffers();
-      events_receiver::poll_events();
+        {
+          TRIMANA_PROFILE_SCOPE(layer->get_profile_name());
+          gapi::opengl::gpu_zone zone(layer->get_name());
+          layer->on_update(delta_time);
+        }
+
+        m_imgui_layer->begin();
+        {
+          TRIMANA_PROFILE_SCOPE("application::on_ui_updates");
+          for (std::shared_ptr<layer> layer : m_layer_stack) 
+            layer->on_ui_updates();
+        } 
+        m_imgui_layer->end();
+
+        m_profiler_layer->end_frame();
+
+        ///////////////////////////////////////////////////////////////////
+        {
+          TRIMANA_PROFILE_SCOPE("window::swap_buffers");
+          m_window->swap_buffers();
+        }
+        {
+          TRIMANA_PROFILE_SCOPE("events_receiver::poll_events");
+          events_receiver::poll_events();
+        }
+      }
+      core::profiling::profiler::collect();
     }
   }
 
@@ -65,12 +87,14 @@ namespace engine::app {
 
   void application::push_layer(std::shared_ptr<layer> layer) 
   {
+    TRIMANA_PROFILE_FUNCTION();
     m_layer_stack.push_layer(layer);
     layer->on_attach();
   }
 
   void application::push_overlay(std::shared_ptr<layer> overlay) 
   {
+    TRIMANA_PROFILE_FUNCTION();
     m_layer_stack.push_overlay(overlay);
     overlay->on_attach();
   }
@@ -4,10 +4,12 @@
 #include <events/events_receiver.hpp>
 #include <inputs/input.hpp>
 #include <layers/imgui_layer.hpp>
+#include <layers/profiler_layer.hpp>
 #include <layers/layer.hpp>
 #include <layers/layer_stack.hpp>
 #include <window/window.hpp>
 #include <utils/time_steps.hpp>
+#include <utils/profiler.hpp>
 
 namespace engine::app {
 
@@ -134,6 +136,14 @@ namespace engine::app {
        */
       core::sptr<core::layers::imgui_layer> m_imgui_layer{nullptr};
 
+      /**
+       * A shared pointer to the profiler layer object.
+       *
+       * The run loop brackets every frame with it and times each layer's
+       * update as a zone of its own.
+       */
+      core::sptr<core::layers::profiler_layer> m_profiler_layer{nullptr};
+
 
       /**
        * The time of the last frame.
@@ -13,6 +13,22 @@ namespace engine::app
     void example_layer::on_attach()
     {
         m_renderer = std::make_shared<gapir::gl_renderer>();
+        m_renderer->init();
+
+        // Shaders compile in the background while the geometry and textures below are set up
+        m_shaders = gapi::shader_container(ggl::make_shader_factory());
+        m_shaders.emplace_source("main", "shaders/main.glsl");
+        m_shader = m_shaders.variant("main");
+        m_texture_shader = m_shaders.variant("main", {{"TEXTURED", "1"}});
+        m_instanced_shader = ggl::make_shader("instanced shader", "shaders/instanced.glsl");
+        m_indirect_shader = ggl::make_shader("indirect shader", "shaders/indirect.glsl");
+        m_quad_shader = ggl::make_shader("quad shader", "shaders/renderer2d.glsl");
+        m_shaders.emplace(m_instanced_shader);
+        m_shaders.emplace(m_indirect_shader);
+        m_shaders.emplace(m_quad_shader);
+
+        // Edited shader sources are rebuilt in the background and swapped in by on_update
+        m_shader_watcher.watch("shaders");
 
         float vertices[] = 
         {
@@ -43,12 +59,19 @@ namespace engine::app
 
         // Square
 
-        float square_vertices[] = {
-            // Position             //Tex coords    // Color
-            -0.5f, -0.5f, 0.0f,     0.0f, 0.0f,     0.2f, 0.3f, 0.8f, 1.0f,
-             0.5f, -0.5f, 0.0f,     1.0f, 0.0f,     0.2f, 0.3f, 0.8f, 1.0f,
-             0.5f,  0.5f, 0.0f,     1.0f, 1.0f,     0.2f, 0.3f, 0.8f, 1.0f,
-            -0.5f,  0.5f, 0.0f,     0.0f, 1.0f,     0.2f, 0.3f, 0.8f, 1.0f
+        struct square_vertex{
+            glm::vec3 position;
+            glm::vec2 texcoord;
+            uint32_t color;     // RGBA8
+        };
+
+        const uint32_t square_color = glm::packUnorm4x8(glm::vec4(0.2f, 0.3f, 0.8f, 1.0f));
+        square_vertex square_vertices[] = {
+            // Position              // Tex coords   // Color
+            { {-0.5f, -0.5f, 0.0f},  {0.0f, 0.0f},   square_color },
+            { { 0.5f, -0.5f, 0.0f},  {1.0f, 0.0f},   square_color },
+            { { 0.5f,  0.5f, 0.0f},  {1.0f, 1.0f},   square_color },
+            { {-0.5f,  0.5f, 0.0f},  {0.0f, 1.0f},   square_color }
         };
 
         unsigned int square_indices[6] = {0, 1, 2, 2, 3, 0};
@@ -56,12 +79,12 @@ namespace engine::app
         m_vertex_array_square = ggl::make_array();
         m_vertex_array_square->bind();
         {
-            std::shared_ptr<vertex_buffer> vertex_buffers_square = ggl::make_vertex(square_vertices, sizeof(square_vertices), ggl::DRAW_STATIC);
+            std::shared_ptr<vertex_buffer> vertex_buffers_square = ggl::make_vertex(reinterpret_cast<float*>(square_vertices), sizeof(square_vertices), ggl::DRAW_STATIC);
 
             buffer_layout layout_square = {
                 { "a_position", XYZ,  F3 },
                 { "a_texcoord",  UV,  F2 },
-                { "a_color",    RGBA, F4 }
+                { "a_color",    RGBA, ATTRIB_U8, true }
             };
 
             vertex_buffers_square->configure_layout(layout_square);
@@ -72,14 +95,110 @@ namespace engine::app
         }
         m_vertex_array_square->unbind();
 
-        m_shader = ggl::make_shader("main shader", "shaders/main.glsl");
-        m_texture_shader = ggl::make_shader("texture shader", "shaders/texture.glsl");
+        // Instanced squares: one mat4 and one color per instance, all drawn with a single call
+
+        struct instance{
+            glm::mat4 model;
+            glm::vec4 color;
+        };
+
+        std::vector<instance> instances;
+        for(int x = 0; x < 100; x++)
+        {
+            for(int y = 0; y < 50; y++)
+            {
+                glm::vec3 pos(-1.0f + x * 0.02f, 0.0f + y * 0.02f, 0.0f);
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), pos) * glm::scale(glm::mat4(1.0f), glm::vec3(0.015f));
+                instances.push_back({model, {x / 100.0f, y / 50.0f, 0.6f, 1.0f}});
+            }
+        }
+        m_instance_count = static_cast<uint32_t>(instances.size());
+
+        m_vertex_array_instanced = ggl::make_array();
+        m_vertex_array_instanced->bind();
+        {
+            std::shared_ptr<vertex_buffer> vertex_buffers_square = ggl::make_vertex(reinterpret_cast<float*>(square_vertices), sizeof(square_vertices), ggl::DRAW_STATIC);
+            vertex_buffers_square->configure_layout({
+                { "a_position", XYZ,  F3 },
+                { "a_texcoord",  UV,  F2 },
+                { "a_color",    RGBA, ATTRIB_U8, true }
+            });
+            m_vertex_array_instanced->emplace_vertex(vertex_buffers_square);
+
+            std::shared_ptr<vertex_buffer> instance_buffer = ggl::make_vertex(reinterpret_cast<float*>(instances.data()),
+                static_cast<uint32_t>(instances.size() * sizeof(instance)), ggl::DRAW_STATIC);
+            instance_buffer->configure_layout({
+                { "a_model",          XYZW, MAT4, false, STEP_INSTANCE },
+                { "a_instance_color", RGBA, F4,   false, STEP_INSTANCE }
+            });
+            m_vertex_array_instanced->emplace_vertex(instance_buffer);
+            m_vertex_array_instanced->emplace_index(ggl::make_index(square_indices, 6, ggl::DRAW_STATIC));
+        }
+        m_vertex_array_instanced->unbind();
+
 
-        m_texture = ggl::make_texture2d("textures/logo-white.png", ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
-        m_texture_new = make_texture2d("textures/logo-no-background.png", ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
+        // Decoded on worker threads and uploaded over the next frames, a placeholder is drawn until then
+        // Nothing here reads pixels back, so only the GPU copies are kept, within a 64 MiB budget
+        m_texture_loader = ggl::make_texture_loader(0, 4 * 1024 * 1024, false);
+        m_texture_residency = ggl::make_texture_residency(64ull * 1024 * 1024, m_texture_loader);
+        {
+            auto logo = m_texture_loader->load("textures/logo-white.png", ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
+            auto logo_new = m_texture_loader->load("textures/logo-no-background.png", ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
+            m_texture_residency->track(logo);
+            m_texture_residency->track(logo_new);
+            m_texture = logo;
+            m_texture_new = logo_new;
+        }
         
+        m_shader->bind();
+        m_shader->uniform("u_model"_uniform, glm::mat4(1.0f));
+        m_shader->uniform("u_color"_uniform, glm::vec4(0.5f, 1.0f, 0.5f, 1.0f));
+
         m_texture_shader->bind();
-        m_texture_shader->uniform("u_texture", (uint32_t)0);
+        m_texture_shader->uniform("u_texture"_uniform, (uint32_t)0);
+
+        m_renderer2d = std::make_shared<gapir::gl_renderer2d>(m_renderer, m_quad_shader);
+        m_renderer2d->init();
+
+        // The 2D scene is drawn offscreen and shown in its own ImGui window
+        m_render_targets = std::make_shared<gapir::framebuffer_pool>(gapir::gapi_factory<ggl::api>::framebuffer, gapir::gapi_factory<ggl::api>::attachment);
+        m_readback = ggl::make_readback();
+
+        // Small generated sprites packed into one atlas page, drawn below in a single batch
+        m_sprites = std::make_shared<gapir::texture_atlas>(gapir::gapi_factory<ggl::api>::texture, 256);
+        for(int32_t i = 0; i < 24; i++)
+        {
+            const int32_t size = 8 + (i % 6) * 6;
+            const float radius = size * 0.5f;
+            std::vector<uint32_t> pixels(size * size);
+            for(int32_t y = 0; y < size; y++)
+            {
+                for(int32_t x = 0; x < size; x++)
+                {
+                    float distance = glm::length(glm::vec2(x + 0.5f - radius, y + 0.5f - radius));
+                    glm::vec4 color(i / 24.0f, 1.0f - i / 24.0f, 0.5f, distance < radius ? 1.0f : 0.0f);
+                    pixels[y * size + x] = glm::packUnorm4x8(color);
+                }
+            }
+            m_sprite_handles.push_back(m_sprites->add(size, size, reinterpret_cast<const uint8_t*>(pixels.data())));
+        }
+        m_sprites->pack();
+
+        // Same sized tiles as layers of one array, any of them draws without another texture unit
+        m_tiles = gapir::gapi_factory<ggl::api>::texture_array(16, 16, 8, 4);
+        for(uint32_t layer = 0; layer < m_tiles->layers(); layer++)
+        {
+            std::vector<uint32_t> pixels(16 * 16);
+            for(int32_t y = 0; y < 16; y++)
+            {
+                for(int32_t x = 0; x < 16; x++)
+                {
+                    const bool stripe = (x + y + static_cast<int32_t>(layer) * 2) % 8 < 4;
+                    pixels[y * 16 + x] = glm::packUnorm4x8(glm::vec4(layer / 8.0f, stripe ? 0.8f : 0.3f, 1.0f - layer / 8.0f, 1.0f));
+                }
+            }
+            m_tiles->set_layer(layer, 0, 0, 16, 16, reinterpret_cast<const uint8_t*>(pixels.data()));
+        }
 
     }
 
@@ -143,18 +262,85 @@ namespace engine::app
 
         ////////////////////////////////////////////////////////////////////
 
+        m_shaders.reload(m_shader_watcher.poll());
+        m_shaders.swap();
+        m_texture_loader->update();
+        m_texture_residency->update();
+
         m_renderer->clear_color(0.1f, 0.1f, 0.1f, 1.0f);
         m_renderer->clear();
 
-        m_shader->bind();
-        m_renderer->submit(m_vertex_array_triangle);
+        m_renderer->begin_frame(glm::mat4(1.0f), static_cast<float>(glfwGetTime()));
+        m_renderer->submit(m_shader, m_vertex_array_triangle);
+        m_renderer->submit_instanced(m_instanced_shader, m_vertex_array_instanced, m_instance_count);
+        for(int x = 0; x < 100; x++)
+        {
+            for(int y = 0; y < 20; y++)
+            {
+                glm::vec3 pos(-1.0f + x * 0.02f, -0.45f + y * 0.02f, 0.0f);
+                gapir::per_draw draw{};
+                draw.model = glm::translate(glm::mat4(1.0f), pos) * glm::scale(glm::mat4(1.0f), glm::vec3(0.015f));
+                draw.color = {0.8f, x / 100.0f, y / 20.0f, 1.0f};
+                m_renderer->submit_indirect(m_indirect_shader, m_vertex_array_square, draw);
+            }
+        }
+        m_renderer->end_frame();
+
+        // Handing last frame's target back first lets the pool return it again instead of allocating
+        m_viewport = nullptr;
+        m_viewport = m_render_targets->acquire({static_cast<int32_t>(m_viewport_size.x), static_cast<int32_t>(m_viewport_size.y)});
+        m_renderer->bind_target(m_viewport);
+        m_renderer->clear();
+
+        m_renderer2d->begin_scene();
+        for(int x = 0; x < 20; x++)
+        {
+            for(int y = 0; y < 20; y++)
+            {
+                glm::vec3 pos(-1.0f + x * 0.1f, -1.0f + y * 0.1f, 0.0f);
+                m_renderer2d->draw_quad(pos, {0.09f, 0.09f}, {0.2f, 0.3f, 0.8f, 1.0f});
+            }
+        }
+        m_renderer2d->draw_quad({-0.5f, -0.5f, 0.0f}, {0.5f, 0.5f}, m_texture);
+        m_renderer2d->draw_quad({ 0.0f,  0.0f, 0.0f}, {0.5f, 0.5f}, m_texture_new);
+        for(size_t i = 0; i < m_sprite_handles.size(); i++)
+            m_renderer2d->draw_quad({-0.95f + i * 0.08f, 0.9f, 0.0f}, {0.07f, 0.07f}, m_sprites->region(m_sprite_handles[i]));
+        for(uint32_t i = 0; i < 24; i++)
+            m_renderer2d->draw_quad({-0.95f + i * 0.08f, 0.8f, 0.0f}, {0.07f, 0.07f}, m_tiles, i % m_tiles->layers());
+        m_renderer2d->end_scene();
+        m_renderer->unbind_target();
+
+        // Recording: every frame of the viewport is copied back asynchronously and written as PNG off the GL thread
+        if(m_capture) m_readback->read(*m_viewport, m_readback->png("captures/frame_" + std::to_string(m_captured++) + ".png"));
+        m_readback->update();
+        m_render_targets->end_frame();
     }
 
     void example_layer::on_ui_updates()
     {
         ImGui::Begin("Settings");
+        const gapir::texture_atlas_stats atlas = m_sprites->stats();
+        ImGui::Text("Sprite atlas: %u images on %u pages, %.0f%% used", atlas.images, atlas.pages, atlas.efficiency() * 100.0f);
+        const ggl::texture_residency_stats residency = m_texture_residency->stats();
+        ImGui::Text("Textures: %u resident, %u evicted, %.1f / %.1f MiB", residency.resident, residency.evicted,
+                    residency.bytes() / (1024.0f * 1024.0f), residency.budget / (1024.0f * 1024.0f));
+        const ggl::state_cache_stats& state = ggl::state_cache::stats();
+        ImGui::Text("GL state changes: %llu issued, %llu elided", static_cast<unsigned long long>(state.issued), static_cast<unsigned long long>(state.elided));
+        ggl::state_cache::reset_stats();
+        const gapir::framebuffer_pool_stats targets = m_render_targets->stats();
+        ImGui::Text("Render targets: %u framebuffers, %u attachments, %u allocated last frame", targets.framebuffers, targets.attachments, targets.frame_allocations);
+        if(ImGui::Checkbox("Record viewport", &m_capture) && m_capture) std::filesystem::create_directories("captures");
+        const ggl::readback_stats capture = m_readback->stats();
+        ImGui::Text("Captures: %u read, %u written, %u stalls", capture.reads, capture.encoded, capture.stalls);
         // ImGui::ColorEdit4("Square Color", glm::value_ptr(m_color));
         ImGui::End();
+
+        ImGui::Begin("Viewport");
+        const ImVec2 available = ImGui::GetContentRegionAvail();
+        if(available.x >= 1.0f && available.y >= 1.0f) m_viewport_size = {available.x, available.y};
+        // Textures are bottom up, ImGui draws top down
+        ImGui::Image((ImTextureID)(intptr_t)m_viewport->color()->id(), {m_viewport_size.x, m_viewport_size.y}, {0.0f, 1.0f}, {1.0f, 0.0f});
+        ImGui::End();
     }
 
     void example_layer::on_event(core::events::event & e)
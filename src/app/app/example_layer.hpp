@@ -4,8 +4,11 @@
 #include <inputs/input.hpp>
 #include <window/window.hpp>
 #include <utils/time_steps.hpp>
+#include <utils/file_watcher.hpp>
 #include <layers/imgui_layer.hpp>
 #include <gapi/gapi_renderer.hpp>
+#include <gapi/gapi_renderer2d.hpp>
+#include <gapi/gapi_framebuffer_pool.hpp>
 
 namespace engine::app
 {
@@ -22,11 +25,27 @@ namespace engine::app
             void on_event(core::events::event& e) override;
 
         private:
-            std::shared_ptr<gapi::shader> m_shader, m_texture_shader;
+            gapi::shader_container m_shaders{};
+            core::files::file_watcher m_shader_watcher{};
+            std::shared_ptr<gapi::shader> m_shader, m_texture_shader, m_quad_shader, m_instanced_shader, m_indirect_shader;
             std::shared_ptr<gapi::texture> m_texture, m_texture_new;
+            std::shared_ptr<ggl::texture_loader> m_texture_loader;
+            std::shared_ptr<ggl::texture_residency> m_texture_residency;
+            std::shared_ptr<gapir::texture_atlas> m_sprites;
+            std::vector<uint32_t> m_sprite_handles;
+            std::shared_ptr<gapi::texture_array> m_tiles;
             std::shared_ptr<gapi::vertex_array> m_vertex_array_triangle;
             std::shared_ptr<gapi::vertex_array> m_vertex_array_square;
+            std::shared_ptr<gapi::vertex_array> m_vertex_array_instanced;
+            uint32_t m_instance_count{0};
             std::shared_ptr<gapir::gl_renderer> m_renderer;
+            std::shared_ptr<gapir::gl_renderer2d> m_renderer2d;
+            std::shared_ptr<gapir::framebuffer_pool> m_render_targets;
+            std::shared_ptr<gapi::framebuffer> m_viewport;
+            glm::vec2 m_viewport_size{640.0f, 360.0f};
+            std::shared_ptr<ggl::readback> m_readback;
+            bool m_capture{false};
+            uint32_t m_captured{0};
 
             // core::renderer::orthographic_camera m_camera{-1.0f, 1.0f, -1.0f, 1.0f};
             // glm::vec3 m_camera_position{0.0f, 0.0f, 0.0f};
@@ -106,6 +106,9 @@ namespace core::windows
             m_context = ggl::make_context(m_window);
             m_context->init();
 
+            // Reuse linked shader programs across launches, keyed by source and driver
+            ggl::program_cache::configure("cache/shaders", *m_context->info());
+
             // Set the window's attributes
             m_attributes.is_active = true;
             m_attributes.is_focused = true;
@@ -3,6 +3,7 @@
 #include <memory>
 #include <type_traits>
 #include <string>
+#include <string_view>
 #include <initializer_list>
 #include <vector>
 #include <algorithm>
@@ -15,12 +16,19 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/vector_angle.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <unordered_map>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <cstddef>
+#include <cstring>
+#include <array>
+#include <span>
+#include <functional>
+
+#include "profiler.hpp"
 
 // Platform detection
 #if defined(_WIN32) || defined(_WIN64)
@@ -74,7 +82,44 @@ namespace gapi{
     enum COMPOENENT : int32_t{
         XYZ     = 3,    XYZW    = 4,
         RGB     = 3,    RGBA    = 4,
-        XY      = 2,    UV      = 2,    NONE    = 0,
+        XY      = 2,    UV      = 2,    X       = 1,
+        NONE    = 0,
+    };
+
+    // Storage type of one attribute component. The 2_10_10_10 formats pack all four
+    // components into 32 bits and must be declared with XYZW or RGBA.
+    enum ATTRIBUTE : uint32_t{
+        ATTRIB_F32          = 0,
+        ATTRIB_F16          = 1,
+        ATTRIB_I8           = 2,
+        ATTRIB_U8           = 3,
+        ATTRIB_I16          = 4,
+        ATTRIB_U16          = 5,
+        ATTRIB_I32          = 6,
+        ATTRIB_U32          = 7,
+        ATTRIB_I2_10_10_10  = 8,
+        ATTRIB_U2_10_10_10  = 9
+    };
+
+    [[nodiscard]] constexpr uint32_t attribute_size(ATTRIBUTE type){
+        switch(type){
+            case ATTRIB_I8: case ATTRIB_U8:                 return 1;
+            case ATTRIB_F16: case ATTRIB_I16: case ATTRIB_U16: return 2;
+            default:                                        return 4;
+        }
+    }
+
+    [[nodiscard]] constexpr bool attribute_packed(ATTRIBUTE type){
+        return type == ATTRIB_I2_10_10_10 || type == ATTRIB_U2_10_10_10;
+    }
+
+    [[nodiscard]] constexpr bool attribute_integer(ATTRIBUTE type){
+        return type != ATTRIB_F32 && type != ATTRIB_F16 && !attribute_packed(type);
+    }
+
+    enum STEP_RATE : uint32_t{
+        STEP_VERTEX     = 0,
+        STEP_INSTANCE   = 1
     };
 
     enum DATA : uint32_t{
@@ -118,15 +163,37 @@ namespace gapi{
 
     struct buffer_elements{
         buffer_elements() {}
-        buffer_elements(const std::string& name, COMPOENENT comp, uint32_t size, bool normalized = false) noexcept
-            : name(name), component(comp), size(size), normalized(normalized) {}
+        buffer_elements(const std::string& name, COMPOENENT comp, uint32_t size, bool normalized = false, STEP_RATE step = STEP_VERTEX) noexcept
+            : name(name), component(comp), size(size), normalized(normalized), step(step) {}
+        // Typed element, e.g. { "a_color", RGBA, ATTRIB_U8, true } is 4 bytes read as a normalized vec4.
+        // Integer types that are not normalized reach the shader as int/uint (ivec, uvec).
+        buffer_elements(const std::string& name, COMPOENENT comp, ATTRIBUTE type, bool normalized = false, STEP_RATE step = STEP_VERTEX) noexcept
+            : name(name), component(comp), type(type), normalized(normalized), step(step) {
+            size = attribute_packed(type) ? 4 : static_cast<uint32_t>(comp) * attribute_size(type);
+        }
         ~buffer_elements() = default;
 
+        // Matrices are declared by their column, { "a_model", XYZW, MAT4 } spans 4 locations.
+        [[nodiscard]] inline uint32_t locations() const {
+            const uint32_t column = attribute_packed(type) ? 4 : static_cast<uint32_t>(component) * attribute_size(type);
+            return column > 0 && size > column ? size / column : 1;
+        }
+
+        [[nodiscard]] inline uint32_t column_size() const {
+            return size / locations();
+        }
+
+        [[nodiscard]] inline bool integer() const {
+            return attribute_integer(type) && !normalized;
+        }
+
         std::string name{};
         COMPOENENT component{COMPOENENT::NONE};
+        ATTRIBUTE type{ATTRIB_F32};
         uint32_t size{0};
         uint32_t offset{0}; 
         bool normalized{false};
+        STEP_RATE step{STEP_VERTEX};
     };
 
     class buffer_layout{
@@ -145,15 +212,16 @@ namespace gapi{
             inline std::vector<buffer_elements>::const_iterator end() const { return m_elements.end(); }
 
         private:
+            // Every attribute starts on a 4-byte boundary, sub-word elements are padded up to it.
             inline void _stride(){
                 m_stride = 0;
                 uint32_t offset = 0;
                 for (auto &element : m_elements)
                 {
                     element.offset = offset;
-                    offset += element.size;
-                    m_stride += element.size; 
+                    offset = (offset + element.size + 3) & ~3u;
                 }
+                m_stride = offset;
             }
 
         private:
@@ -161,6 +229,123 @@ namespace gapi{
             uint32_t m_stride{0};
     };
 
+    enum STD140 : uint32_t{
+        STD140_FLOAT,   STD140_INT,     STD140_UINT,    STD140_BOOL,
+        STD140_VEC2,    STD140_VEC3,    STD140_VEC4,
+        STD140_IVEC2,   STD140_IVEC3,   STD140_IVEC4,
+        STD140_MAT2,    STD140_MAT3,    STD140_MAT4
+    };
+
+    struct std140_element{
+        constexpr std140_element(STD140 type, uint32_t count = 1) noexcept : type(type), count(count) {}
+
+        STD140 type;
+        uint32_t count;
+    };
+
+    namespace std140{
+
+        constexpr uint32_t round_up(uint32_t v, uint32_t a) { return (v + a - 1) / a * a; }
+
+        constexpr uint32_t base_alignment(STD140 type){
+            switch(type){
+                case STD140_VEC2: case STD140_IVEC2:                    return 8;
+                case STD140_VEC3: case STD140_VEC4:
+                case STD140_IVEC3: case STD140_IVEC4:
+                case STD140_MAT2: case STD140_MAT3: case STD140_MAT4:   return 16;
+                default:                                                return 4;
+            }
+        }
+
+        // Matrices are stored as arrays of column vectors, each padded to a vec4.
+        constexpr uint32_t base_size(STD140 type){
+            switch(type){
+                case STD140_VEC2: case STD140_IVEC2:    return 8;
+                case STD140_VEC3: case STD140_IVEC3:    return 12;
+                case STD140_VEC4: case STD140_IVEC4:    return 16;
+                case STD140_MAT2:                       return 32;
+                case STD140_MAT3:                       return 48;
+                case STD140_MAT4:                       return 64;
+                default:                                return 4;
+            }
+        }
+
+        constexpr uint32_t alignment(std140_element e){
+            return e.count > 1 ? round_up(base_alignment(e.type), 16) : base_alignment(e.type);
+        }
+
+        constexpr uint32_t array_stride(std140_element e){
+            return round_up(base_size(e.type), 16);
+        }
+
+        constexpr uint32_t size(std140_element e){
+            return e.count > 1 ? e.count * array_stride(e) : base_size(e.type);
+        }
+    }
+
+    template<std140_element... Elements>
+    class std140_layout{
+
+        public:
+            static constexpr size_t count = sizeof...(Elements);
+
+        private:
+            static constexpr std::array<std140_element, count> s_elements{Elements...};
+
+            static constexpr std::array<uint32_t, count + 1> compute(){
+                std::array<uint32_t, count + 1> offsets{};
+                uint32_t offset = 0;
+                for(size_t i = 0; i < count; i++){
+                    offset = std140::round_up(offset, std140::alignment(s_elements[i]));
+                    offsets[i] = offset;
+                    offset += std140::size(s_elements[i]);
+                }
+                offsets[count] = std140::round_up(offset, 16);
+                return offsets;
+            }
+
+            static constexpr std::array<uint32_t, count + 1> s_offsets = compute();
+
+        public:
+            static constexpr uint32_t size = s_offsets[count];
+
+            template<size_t I>
+            static constexpr uint32_t offset = s_offsets[I];
+
+            template<size_t I>
+            static constexpr std140_element element = s_elements[I];
+    };
+
+    template<typename Layout>
+    class std140_block{
+
+        public:
+            std140_block() = default;
+            ~std140_block() = default;
+
+            template<size_t I, typename Ty>
+            void set(const Ty& value, uint32_t index = 0){
+                constexpr std140_element e = Layout::template element<I>;
+                gapi_asserts(index < e.count, "std140 array index out of range");
+                uint8_t* dst = m_data.data() + Layout::template offset<I> + index * std140::array_stride(e);
+
+                if constexpr (std::is_same_v<Ty, glm::mat2> || std::is_same_v<Ty, glm::mat3>){
+                    for(int32_t c = 0; c < Ty::length(); c++)
+                        std::memcpy(dst + c * 16, &value[c], sizeof(value[c]));
+                }
+                else{
+                    static_assert(sizeof(Ty) <= std140::base_size(e.type), "Value does not fit the std140 element");
+                    std::memcpy(dst, &value, sizeof(Ty));
+                }
+            }
+
+            [[nodiscard]] inline const uint8_t* data() const { return m_data.data(); }
+            [[nodiscard]] static constexpr uint32_t size() { return Layout::size; }
+
+        private:
+            std::array<uint8_t, Layout::size> m_data{};
+    };
+
     class vertex_buffer{
         public:
             constexpr vertex_buffer() = default;
@@ -169,10 +354,70 @@ namespace gapi{
             virtual void bind() const = 0;
             [[maybe_unused]] virtual void unbind() const = 0;
 
+            virtual void set_data(const void* data, uint32_t size) = 0;
             virtual void configure_layout(const buffer_layout& layout) = 0;
             virtual const buffer_layout& layout() const = 0;
+
+            // Writes into the existing storage at a byte offset, the buffer object is kept.
+            virtual void set_data(uint32_t offset, std::span<const std::byte> data) = 0;
+            // Detaches the old storage before writing so the driver never waits on in-flight draws.
+            virtual void orphan(std::span<const std::byte> data) = 0;
+            // Reallocates the storage, previous contents are discarded.
+            virtual void resize(uint32_t size) = 0;
+            virtual uint32_t size() const = 0;
+
+            template<typename T>
+            void set_data(uint32_t offset, std::span<T> data){
+                set_data(offset, std::as_bytes(data));
+            }
+
+            template<typename T>
+            void orphan(std::span<T> data){
+                orphan(std::as_bytes(data));
+            }
     };
 
+    struct stream_allocation{
+        void* data{nullptr};
+        uint32_t offset{0};
+        uint32_t size{0};
+    };
+
+    // Ring of per-frame regions that producers write into directly. reserve() hands out
+    // a pointer into the current region, commit() publishes how much of it was written.
+    // Only reserve() tells where data lands, so the vertex_buffer writes set_data() and
+    // orphan() assert and write nothing; draw from stream_allocation::offset instead.
+    class stream_buffer : public vertex_buffer{
+        public:
+            stream_buffer() = default;
+            virtual ~stream_buffer() = default;
+
+            virtual void begin_frame() = 0;
+            virtual void end_frame() = 0;
+            virtual stream_allocation reserve(uint32_t size, uint32_t alignment) = 0;
+            virtual void commit(uint32_t size) = 0;
+            // Bytes reserve() can still hand out from the current region without moving to the next.
+            virtual uint32_t remaining(uint32_t alignment) const = 0;
+
+            virtual uint32_t frame_size() const = 0;
+            virtual uint32_t frames() const = 0;
+            virtual uint32_t stalls() const = 0;
+    };
+
+    // Enumerator values are the width of one index in bytes.
+    enum INDEX : uint32_t{
+        INDEX_U16       = 2,
+        INDEX_U32       = 4
+    };
+
+    // Narrowest index type able to address every vertex referenced by indices.
+    [[nodiscard]] inline INDEX index_type_for(std::span<const uint32_t> indices){
+        for(uint32_t i : indices){
+            if(i > 0xFFFF) return INDEX_U32;
+        }
+        return INDEX_U16;
+    }
+
     class index_buffer{
         public:
             index_buffer() = default;
@@ -181,6 +426,105 @@ namespace gapi{
             virtual void bind() const = 0;
             [[maybe_unused]] virtual void unbind() const = 0;
             virtual uint32_t count() const = 0;
+            virtual INDEX type() const = 0;
+
+            // Bytes of index storage allocated, capacity() * width.
+            [[nodiscard]] inline uint32_t bytes() const { return capacity() * static_cast<uint32_t>(type()); }
+
+            // Offsets and sizes are in indices. Writing past count() extends the drawn range.
+            // 16-bit buffers narrow the values on upload, they must stay below 65536.
+            virtual void set_data(uint32_t offset, std::span<const uint32_t> indices) = 0;
+            // Replaces the whole contents, count() becomes indices.size().
+            virtual void orphan(std::span<const uint32_t> indices) = 0;
+            // Reallocates room for count indices, count() drops to zero until data is written.
+            virtual void resize(uint32_t count) = 0;
+            virtual uint32_t capacity() const = 0;
+    };
+
+    enum UNIFORM_BINDING : uint32_t{
+        UNIFORM_BINDING_PER_FRAME       = 0,
+        UNIFORM_BINDING_PER_MATERIAL    = 1,
+        UNIFORM_BINDING_NONE            = 0xFFFFFFFF
+    };
+
+    // Maps uniform block names to binding points, shaders bind their blocks through it after linking.
+    class uniform_bindings{
+
+        public:
+            static uint32_t reserve(const std::string& block){
+                uint32_t existing = binding(block);
+                if(existing != UNIFORM_BINDING_NONE) return existing;
+                s_bindings.emplace_back(block, s_next);
+                return s_next++;
+            }
+
+            [[nodiscard]] static uint32_t binding(std::string_view block){
+                for(const auto& [name, point] : s_bindings)
+                    if(name == block) return point;
+                return UNIFORM_BINDING_NONE;
+            }
+
+        private:
+            inline static std::vector<std::pair<std::string, uint32_t>> s_bindings{
+                {"per_frame", UNIFORM_BINDING_PER_FRAME},
+                {"per_material", UNIFORM_BINDING_PER_MATERIAL}
+            };
+            inline static uint32_t s_next{UNIFORM_BINDING_PER_MATERIAL + 1};
+    };
+
+    class uniform_buffer{
+        public:
+            uniform_buffer() = default;
+            virtual ~uniform_buffer() = default;
+
+            virtual void bind() const = 0;
+            virtual void set_data(const void* data, uint32_t size, uint32_t offset = 0) = 0;
+            virtual uint32_t binding() const = 0;
+            virtual uint32_t size() const = 0;
+
+            template<typename Layout>
+            void set_data(const std140_block<Layout>& block){
+                set_data(block.data(), block.size());
+            }
+    };
+
+    // Matches the record glMultiDrawElementsIndirect reads, one per draw.
+    struct draw_indirect_command{
+        uint32_t count{0};
+        uint32_t instance_count{1};
+        uint32_t first_index{0};
+        int32_t base_vertex{0};
+        uint32_t base_instance{0};
+    };
+
+    static_assert(sizeof(draw_indirect_command) == 20, "draw_indirect_command must match the GL layout");
+
+    class indirect_buffer{
+        public:
+            indirect_buffer() = default;
+            virtual ~indirect_buffer() = default;
+
+            virtual void bind() const = 0;
+            [[maybe_unused]] virtual void unbind() const = 0;
+            // Replaces the contents, growing the storage when the commands do not fit.
+            virtual void set_data(std::span<const draw_indirect_command> commands) = 0;
+            virtual uint32_t capacity() const = 0;
+    };
+
+    enum STORAGE_BINDING : uint32_t{
+        STORAGE_BINDING_PER_DRAW        = 0
+    };
+
+    class storage_buffer{
+        public:
+            storage_buffer() = default;
+            virtual ~storage_buffer() = default;
+
+            virtual void bind() const = 0;
+            // Replaces the contents, growing the storage when the data does not fit.
+            virtual void set_data(const void* data, uint32_t size) = 0;
+            virtual uint32_t binding() const = 0;
+            virtual uint32_t size() const = 0;
     };
 
     class vertex_array{
@@ -191,6 +535,7 @@ namespace gapi{
 
             virtual void bind() const = 0;
             [[maybe_unused]] virtual void unbind() const = 0;
+            virtual uint32_t id() const = 0;
 
             virtual void emplace_vertex(const std::shared_ptr<vertex_buffer>& vertex_buffer)  = 0;
             virtual void emplace_index(const std::shared_ptr<index_buffer>& index_buffer) = 0;
@@ -198,6 +543,49 @@ namespace gapi{
             inline virtual const std::shared_ptr<index_buffer>& index() const = 0;
     };
 
+    // Locations change when shader::swap() installs a rebuilt program. A handle from an older
+    // program is looked up again by its name hash on every use, so re-fetch cached handles
+    // after swap() returns true to keep that lookup off per-frame paths.
+    struct uniform_handle{
+        int32_t location{-1};
+        uint32_t hash{0};
+        uint32_t generation{0};
+
+        [[nodiscard]] inline bool valid() const { return location >= 0; }
+    };
+
+    constexpr uint64_t fnv1a64_basis = 14695981039346656037ull;
+
+    [[nodiscard]] constexpr uint64_t fnv1a64(uint64_t hash, std::string_view data){
+        for(char c : data){
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    struct uniform_hash{
+        uint32_t value{0};
+
+        constexpr uniform_hash() = default;
+        constexpr explicit uniform_hash(std::string_view n) : value(fnv1a(n)) {}
+
+        static constexpr uint32_t fnv1a(std::string_view n){
+            uint32_t hash = 2166136261u;
+            for(char c : n){
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    };
+
+    inline namespace literals{
+        consteval uniform_hash operator""_uniform(const char* n, size_t length){
+            return uniform_hash{std::string_view(n, length)};
+        }
+    }
+
     class shader{
         public:
             shader() = default;
@@ -207,17 +595,41 @@ namespace gapi{
             [[maybe_unused]] virtual void unbind() const = 0;
 
             virtual const std::string& name() const = 0;
-            virtual bool uniform(const std::string& n, uint32_t v) const = 0;
-            virtual bool uniform(const std::string& n, float v) const = 0;
-            virtual bool uniform(const std::string& n, float x, float y) const = 0;
-            virtual bool uniform(const std::string& n, float x, float y, float z) const = 0;
-            virtual bool uniform(const std::string& n, float x, float y, float z, float w) const = 0;
-            virtual bool uniform(const std::string& n, const glm::vec2& v) const = 0;
-            virtual bool uniform(const std::string& n, const glm::vec3& v) const = 0;
-            virtual bool uniform(const std::string& n, const glm::vec4& v) const = 0;
-            virtual bool uniform(const std::string& n, const glm::mat2& v) const = 0;
-            virtual bool uniform(const std::string& n, const glm::mat3& v) const = 0;
-            virtual bool uniform(const std::string& n, const glm::mat4& v) const = 0;
+            virtual uint32_t id() const = 0;
+            // Programs may still be compiling after creation. ready() polls without blocking,
+            // resolve() waits for the result; bind() and handle() resolve on their own.
+            virtual bool ready() const = 0;
+            virtual void resolve() const = 0;
+            // Hot reload: reload() rebuilds from sources() off the render thread and leaves the live
+            // program in use; swap() installs the rebuild at a frame boundary once it has linked.
+            virtual const std::vector<std::filesystem::path>& sources() const = 0;
+            virtual void reload() = 0;
+            virtual bool swap() = 0;
+            virtual uniform_handle handle(std::string_view n) const = 0;
+            virtual uniform_handle handle(uniform_hash h) const = 0;
+            virtual bool uniform(uniform_handle h, uint32_t v) const = 0;
+            virtual bool uniform(uniform_handle h, float v) const = 0;
+            virtual bool uniform(uniform_handle h, float x, float y) const = 0;
+            virtual bool uniform(uniform_handle h, float x, float y, float z) const = 0;
+            virtual bool uniform(uniform_handle h, float x, float y, float z, float w) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::vec2& v) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::vec3& v) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::vec4& v) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::mat2& v) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::mat3& v) const = 0;
+            virtual bool uniform(uniform_handle h, const glm::mat4& v) const = 0;
+            virtual bool uniform(uniform_handle h, const int32_t* v, uint32_t count) const = 0;
+
+            // Hashes n on every call; per-frame code should pass "name"_uniform, hashed at compile time.
+            template<typename... TArgs>
+            bool uniform(std::string_view n, TArgs&&... args) const {
+                return uniform(handle(n), std::forward<TArgs>(args)...);
+            }
+
+            template<typename... TArgs>
+            bool uniform(uniform_hash h, TArgs&&... args) const {
+                return uniform(handle(h), std::forward<TArgs>(args)...);
+            }
     };
 
     class texture{
@@ -233,6 +645,65 @@ namespace gapi{
             virtual int32_t width() const = 0;
             virtual int32_t height() const = 0;
             virtual int32_t channels() const = 0;
+            // False while an asynchronously loaded texture is still decoding or uploading;
+            // bind() uses a placeholder until then.
+            virtual bool ready() const = 0;
+            // Replaces a sub rectangle with tightly packed pixels in the texture's channel count.
+            // A mipmapped texture regenerates every level afterwards, so batch writes where possible.
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) = 0;
+    };
+
+    // Same sized layers in one texture object, shaders select the layer by index so drawing from
+    // any of them needs a single texture unit. set_data() writes layer 0.
+    class texture_array : public texture{
+        public:
+            virtual uint32_t layers() const = 0;
+            // Replaces a sub rectangle of one layer with tightly packed pixels in the texture's channel count.
+            virtual void set_layer(uint32_t layer, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) = 0;
+    };
+
+    enum ATTACHMENT_FORMAT : uint32_t{
+        ATTACHMENT_NONE                 = 0,
+        ATTACHMENT_RGBA8                = 1,
+        ATTACHMENT_RGBA16F              = 2,
+        ATTACHMENT_DEPTH24_STENCIL8     = 3,
+        ATTACHMENT_DEPTH32F             = 4
+    };
+
+    [[nodiscard]] inline constexpr bool depth_format(ATTACHMENT_FORMAT format){
+        return format == ATTACHMENT_DEPTH24_STENCIL8 || format == ATTACHMENT_DEPTH32F;
+    }
+
+    struct framebuffer_spec{
+        int32_t width{0};
+        int32_t height{0};
+        std::vector<ATTACHMENT_FORMAT> colors{ATTACHMENT_RGBA8};
+        ATTACHMENT_FORMAT depth{ATTACHMENT_DEPTH24_STENCIL8};
+
+        bool operator==(const framebuffer_spec&) const = default;
+    };
+
+    // Creates the sampleable texture behind one framebuffer attachment.
+    using attachment_factory = std::function<std::shared_ptr<texture>(ATTACHMENT_FORMAT format, int32_t width, int32_t height)>;
+
+    // Offscreen render target. Attachments are ordinary textures, so a pass can sample what an
+    // earlier one drew and ImGui can show them through their id.
+    class framebuffer{
+        public:
+            framebuffer() = default;
+            virtual ~framebuffer() = default;
+
+            // Also sets the viewport to the framebuffer size.
+            virtual void bind() const = 0;
+            // Back to the default framebuffer and a viewport covering the window.
+            virtual void unbind() const = 0;
+            // New attachments come from the factory the framebuffer was created with.
+            virtual void resize(int32_t width, int32_t height) = 0;
+
+            virtual uint32_t id() const = 0;
+            virtual const framebuffer_spec& spec() const = 0;
+            virtual const std::shared_ptr<texture>& color(uint32_t index = 0) const = 0;
+            virtual const std::shared_ptr<texture>& depth() const = 0;
     };
 
     class base_api{
@@ -243,15 +714,79 @@ namespace gapi{
 
             virtual void init() = 0;
             virtual void draw(const std::shared_ptr<vertex_array>& va) = 0;
+            virtual void draw(const vertex_array& va, uint32_t count) = 0;
+            virtual void draw(const vertex_array& va, uint32_t count, uint32_t base_vertex) = 0;
+            virtual void draw_instanced(const vertex_array& va, uint32_t instance_count) = 0;
+            // Issues draw_count commands starting at record first; va must already be bound.
+            virtual void draw_indirect(const vertex_array& va, const indirect_buffer& commands, uint32_t first, uint32_t draw_count) = 0;
+            // Issues one indirect command straight from the CPU; va must already be bound.
+            virtual void draw(const vertex_array& va, const draw_indirect_command& command) = 0;
             virtual void clear()  = 0;
             virtual void clear_color(float r, float g, float b, float a) = 0;   
+            // Leaves no texture on slot, so a draw without one can't sample what an earlier draw left.
+            virtual void unbind_texture(uint32_t slot) = 0;
+            virtual uint32_t max_texture_slots() const = 0;
+            // Whether shaders can read gl_DrawID, which multi-draws need to tell their draws apart.
+            virtual bool draw_parameters() const = 0;
             virtual GAPI xapi() const  = 0;   
     };
 
+    // #define set injected after a shader's #version line. Kept sorted by name so the
+    // permutation key does not depend on the order the defines were added in.
+    class shader_defines{
+
+        public:
+            shader_defines() = default;
+            shader_defines(std::initializer_list<std::pair<std::string, std::string>> defines){
+                for(const auto& [name, value] : defines) define(name, value);
+            }
+            ~shader_defines() = default;
+
+            shader_defines& define(const std::string& name, const std::string& value = "1"){
+                auto it = std::lower_bound(m_defines.begin(), m_defines.end(), name, [](const auto& d, const std::string& n){ return d.first < n; });
+                if(it != m_defines.end() && it->first == name) it->second = value;
+                else m_defines.insert(it, {name, value});
+                return *this;
+            }
+
+            // One NAME=VALUE line per define; equal sets give equal keys and different sets never collide.
+            [[nodiscard]] std::string key() const{
+                std::string key;
+                for(const auto& [name, value] : m_defines)
+                    key += name + "=" + value + "\n";
+                return key;
+            }
+
+            // Short form for names and logs, e.g. "TEXTURED=1,LIGHTS=4".
+            [[nodiscard]] std::string label() const{
+                std::string label;
+                for(const auto& [name, value] : m_defines)
+                    label += (label.empty() ? "" : ",") + name + "=" + value;
+                return label;
+            }
+
+            [[nodiscard]] std::string source() const{
+                std::string lines;
+                for(const auto& [name, value] : m_defines)
+                    lines += "#define " + name + " " + value + "\n";
+                return lines;
+            }
+
+            [[nodiscard]] inline bool empty() const { return m_defines.empty(); }
+
+        private:
+            std::vector<std::pair<std::string, std::string>> m_defines{};
+    };
+
+    using shader_factory = std::function<std::shared_ptr<shader>(const std::string& name, const std::filesystem::path& path, const shader_defines& defines)>;
+    using texture_factory = std::function<std::shared_ptr<texture>(int32_t width, int32_t height, int32_t channels)>;
+    using framebuffer_factory = std::function<std::shared_ptr<framebuffer>(const framebuffer_spec& spec, attachment_factory attachments)>;
+
     class shader_container{
 
         public:
             shader_container() = default;
+            explicit shader_container(shader_factory factory) : m_factory(std::move(factory)) {}
             ~shader_container() = default;
 
             void emplace(const std::shared_ptr<shader>& shader){
@@ -261,12 +796,71 @@ namespace gapi{
             }
 
             template<typename Ty, typename... TArgs>
-            [[nodiscard]] std::shared_ptr<shader> load(TArgs... args) const {
+            [[nodiscard]] std::shared_ptr<shader> load(TArgs... args) {
                 auto shader = make_shader<Ty>(std::forward<TArgs>(args)...);
                 emplace(shader);
                 return shader;
             }
 
+            void emplace_source(const std::string& name, const std::filesystem::path& path){
+                m_sources[name] = path;
+            }
+
+            // Permutation of a registered source, compiled on first request and memoized by
+            // (name, defines) so only the variants a scene actually uses are ever built. Each one is
+            // named after both, "main[TEXTURED=1]", so logs and profiles tell them apart.
+            [[nodiscard]] std::shared_ptr<shader> variant(const std::string& name, const shader_defines& defines = {}){
+                const std::string key = name + "\n" + defines.key();
+                auto it = m_variants.find(key);
+                if(it != m_variants.end()) return it->second;
+
+                auto source = m_sources.find(name);
+                gapi_asserts(source != m_sources.end(), "Shader source not registered");
+                gapi_asserts(m_factory != nullptr, "Shader container has no factory for variants");
+                if(source == m_sources.end() || m_factory == nullptr) return nullptr;
+
+                auto shader = m_factory(defines.empty() ? name : name + "[" + defines.label() + "]", source->second, defines);
+                m_variants.emplace(key, shader);
+                return shader;
+            }
+
+            [[nodiscard]] inline size_t variants() const { return m_variants.size(); }
+
+            // Every shader starts compiling when it is created; poll this between other loading work.
+            [[nodiscard]] bool ready() const{
+                auto ready = [](const auto& entry){ return entry.second->ready(); };
+                return std::all_of(m_shaders.begin(), m_shaders.end(), ready) && std::all_of(m_variants.begin(), m_variants.end(), ready);
+            }
+
+            // Blocks until every shader is linked, typically at the end of a loading phase.
+            void resolve() const{
+                for(const auto& [name, shader] : m_shaders) shader->resolve();
+                for(const auto& [key, shader] : m_variants) shader->resolve();
+            }
+
+            // Starts a rebuild of every shader built from one of the changed files.
+            uint32_t reload(const std::vector<std::filesystem::path>& changed){
+                if(changed.empty()) return 0;
+                uint32_t count{0};
+                auto reload = [&](const std::shared_ptr<shader>& shader){
+                    const auto& sources = shader->sources();
+                    if(std::find_first_of(sources.begin(), sources.end(), changed.begin(), changed.end()) == sources.end()) return;
+                    shader->reload();
+                    count++;
+                };
+                for(const auto& [name, shader] : m_shaders) reload(shader);
+                for(const auto& [key, shader] : m_variants) reload(shader);
+                return count;
+            }
+
+            // Call between frames; never waits for a rebuild, failed ones keep their previous program.
+            uint32_t swap(){
+                uint32_t count{0};
+                for(const auto& [name, shader] : m_shaders) count += shader->swap() ? 1 : 0;
+                for(const auto& [key, shader] : m_variants) count += shader->swap() ? 1 : 0;
+                return count;
+            }
+
             [[nodiscard]] std::shared_ptr<shader> get(const std::string& name) const{
                 auto it = m_shaders.find(name);
                 gapi_asserts(it != m_shaders.end(), "Shader not found");
@@ -275,5 +869,8 @@ namespace gapi{
 
         private:
             std::unordered_map<std::string, std::shared_ptr<shader>> m_shaders{};
+            std::unordered_map<std::string, std::filesystem::path> m_sources{};
+            std::unordered_map<std::string, std::shared_ptr<shader>> m_variants{};
+            shader_factory m_factory{};
     };
 }
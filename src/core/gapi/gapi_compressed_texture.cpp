@@ -0,0 +1,267 @@
+#include "gapi_compressed_texture.hpp"
+
+namespace gapi{
+
+    static constexpr uint8_t s_dds_magic[4]   = {'D', 'D', 'S', ' '};
+    static constexpr uint8_t s_ktx2_magic[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    template<typename T>
+    static T read(const std::vector<uint8_t>& file, size_t offset){
+        T value{};
+        if(offset + sizeof(T) <= file.size()) std::memcpy(&value, file.data() + offset, sizeof(T));
+        return value;
+    }
+
+    static uint32_t fourcc(const char (&code)[5]){
+        return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8 | static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+    }
+
+    static std::vector<uint8_t> read_file(const std::filesystem::path& path){
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if(!file) return {};
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    bool compressed_container(const std::filesystem::path& path){
+        uint8_t header[12]{};
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if(!file.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+        return std::memcmp(header, s_dds_magic, sizeof(s_dds_magic)) == 0 || std::memcmp(header, s_ktx2_magic, sizeof(s_ktx2_magic)) == 0;
+    }
+
+    // Containers store the size as unsigned; anything empty or larger than a texture can be is rejected
+    // before the level sizes are computed from it.
+    static bool read_extent(uint32_t width, uint32_t height, compressed_image& image){
+        if(width == 0 || height == 0 || width > max_block_dimension || height > max_block_dimension){
+            gapi_debug_msg("Unsupported compressed texture size: ", std::to_string(width) + "x" + std::to_string(height));
+            return false;
+        }
+        image.width = static_cast<int32_t>(width);
+        image.height = static_cast<int32_t>(height);
+        return true;
+    }
+
+    static BLOCK_FORMAT dxgi_format(uint32_t dxgi, bool& srgb){
+        srgb = dxgi == 72 || dxgi == 75 || dxgi == 78 || dxgi == 99;
+        switch(dxgi){
+            case 70: case 71: case 72:  return BLOCK_BC1A;
+            case 73: case 74: case 75:  return BLOCK_BC2;
+            case 76: case 77: case 78:  return BLOCK_BC3;
+            case 79: case 80:           return BLOCK_BC4;
+            case 82: case 83:           return BLOCK_BC5;
+            case 97: case 98: case 99:  return BLOCK_BC7;
+            default:                    return BLOCK_NONE;
+        }
+    }
+
+    static BLOCK_FORMAT vk_format(uint32_t vk, bool& srgb){
+        srgb = vk == 132 || vk == 134 || vk == 136 || vk == 138 || vk == 146;
+        switch(vk){
+            case 131: case 132: return BLOCK_BC1;
+            case 133: case 134: return BLOCK_BC1A;
+            case 135: case 136: return BLOCK_BC2;
+            case 137: case 138: return BLOCK_BC3;
+            case 139:           return BLOCK_BC4;
+            case 141:           return BLOCK_BC5;
+            case 145: case 146: return BLOCK_BC7;
+            default:            return BLOCK_NONE;
+        }
+    }
+
+    static bool load_dds(std::vector<uint8_t>& file, compressed_image& image){
+        constexpr uint32_t header = 4;
+        constexpr uint32_t dds_alpha_pixels = 0x1, dds_mipmap_count = 0x20000, dds_cubemap = 0x200;
+        if(file.size() < header + 124 || read<uint32_t>(file, header) != 124) return false;
+
+        const uint32_t flags = read<uint32_t>(file, header + 4);
+        if(!read_extent(read<uint32_t>(file, header + 12), read<uint32_t>(file, header + 8), image)) return false;
+        const uint32_t mips = flags & dds_mipmap_count ? std::max(1u, read<uint32_t>(file, header + 24)) : 1;
+        const uint32_t pixel_flags = read<uint32_t>(file, header + 76);
+        const uint32_t code = read<uint32_t>(file, header + 80);
+        if(read<uint32_t>(file, header + 108) & dds_cubemap){
+            gapi_debug_msg("DDS cube maps are not supported", "");
+            return false;
+        }
+
+        size_t offset = header + 124;
+        if(code == fourcc("DX10")){
+            if(read<uint32_t>(file, offset + 4) != 3 || read<uint32_t>(file, offset + 12) > 1 || read<uint32_t>(file, offset + 8) & 0x4){
+                gapi_debug_msg("DDS arrays, cube maps and non 2D resources are not supported", "");
+                return false;
+            }
+            image.format = dxgi_format(read<uint32_t>(file, offset), image.srgb);
+            offset += 20;
+        }
+        else if(code == fourcc("DXT1"))                             image.format = pixel_flags & dds_alpha_pixels ? BLOCK_BC1A : BLOCK_BC1;
+        else if(code == fourcc("DXT2") || code == fourcc("DXT3"))   image.format = BLOCK_BC2;
+        else if(code == fourcc("DXT4") || code == fourcc("DXT5"))   image.format = BLOCK_BC3;
+        else if(code == fourcc("ATI1") || code == fourcc("BC4U"))   image.format = BLOCK_BC4;
+        else if(code == fourcc("ATI2") || code == fourcc("BC5U"))   image.format = BLOCK_BC5;
+
+        if(image.format == BLOCK_NONE){
+            gapi_debug_msg("Unsupported DDS pixel format", "");
+            return false;
+        }
+
+        int32_t width = image.width, height = image.height;
+        for(uint32_t level = 0; level < mips; level++){
+            const uint64_t size = block_level_size(image.format, width, height);
+            if(offset > file.size() || size > file.size() - offset) break;
+            image.levels.push_back({width, height, offset, static_cast<size_t>(size)});
+            offset += size;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+
+    static bool load_ktx2(std::vector<uint8_t>& file, compressed_image& image){
+        constexpr size_t level_index = 80;
+        if(file.size() < level_index) return false;
+
+        image.format = vk_format(read<uint32_t>(file, 12), image.srgb);
+        const uint32_t depth = read<uint32_t>(file, 28), layers = read<uint32_t>(file, 32), faces = read<uint32_t>(file, 36);
+        const uint32_t levels = std::max(1u, read<uint32_t>(file, 40));
+        const uint32_t supercompression = read<uint32_t>(file, 44);
+
+        if(image.format == BLOCK_NONE){
+            gapi_debug_msg("Unsupported KTX2 vkFormat: ", read<uint32_t>(file, 12));
+            return false;
+        }
+        if(depth > 0 || layers > 1 || faces != 1 || supercompression != 0){
+            gapi_debug_msg("KTX2 arrays, cube maps, 3D and supercompressed textures are not supported", "");
+            return false;
+        }
+        if(!read_extent(read<uint32_t>(file, 20), read<uint32_t>(file, 24), image)) return false;
+
+        int32_t width = image.width, height = image.height;
+        for(uint32_t level = 0; level < levels; level++){
+            const size_t entry = level_index + static_cast<size_t>(level) * 24;
+            const uint64_t offset = read<uint64_t>(file, entry);
+            const uint64_t size = read<uint64_t>(file, entry + 8);
+            if(size < block_level_size(image.format, width, height) || offset > file.size() || size > file.size() - offset) break;
+            image.levels.push_back({width, height, static_cast<size_t>(offset), static_cast<size_t>(size)});
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+
+    bool load_compressed(const std::filesystem::path& path, compressed_image& image){
+        image = {};
+        std::vector<uint8_t> file = read_file(path);
+        bool loaded = false;
+        if(file.size() >= sizeof(s_ktx2_magic) && std::memcmp(file.data(), s_ktx2_magic, sizeof(s_ktx2_magic)) == 0)
+            loaded = load_ktx2(file, image);
+        else if(file.size() >= sizeof(s_dds_magic) && std::memcmp(file.data(), s_dds_magic, sizeof(s_dds_magic)) == 0)
+            loaded = load_dds(file, image);
+
+        if(!loaded || !image.valid()){
+            gapi_debug_msg("Failed to load compressed texture: ", path.string());
+            image = {};
+            return false;
+        }
+
+        image.data = std::move(file);
+        return true;
+    }
+
+    // Endpoints are RGB565; the two interpolated colors follow the BC1 rules, except that BC2 and
+    // BC3 color blocks always use four colors.
+    static void decode_color(const uint8_t* block, bool four_colors, bool punch_through, uint8_t (&texels)[16][4]){
+        const uint32_t c0 = block[0] | block[1] << 8;
+        const uint32_t c1 = block[2] | block[3] << 8;
+
+        uint32_t palette[4][4]{};
+        for(uint32_t i = 0; i < 2; i++){
+            const uint32_t c = i == 0 ? c0 : c1;
+            const uint32_t r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+            palette[i][0] = r << 3 | r >> 2;
+            palette[i][1] = g << 2 | g >> 4;
+            palette[i][2] = b << 3 | b >> 2;
+            palette[i][3] = 255;
+        }
+        for(uint32_t channel = 0; channel < 3; channel++){
+            if(four_colors || c0 > c1){
+                palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+                palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+            }
+            else{
+                palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+                palette[3][channel] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = four_colors || c0 > c1 || !punch_through ? 255 : 0;
+
+        const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+        for(uint32_t i = 0; i < 16; i++){
+            const uint32_t* color = palette[(indices >> (2 * i)) & 3];
+            for(uint32_t channel = 0; channel < 4; channel++) texels[i][channel] = static_cast<uint8_t>(color[channel]);
+        }
+    }
+
+    // BC3 alpha and BC4/BC5 channels: two endpoints and 3-bit indices into eight values.
+    static void decode_channel(const uint8_t* block, uint8_t (&texels)[16][4], uint32_t channel){
+        const uint32_t a0 = block[0], a1 = block[1];
+        uint32_t palette[8]{a0, a1};
+        if(a0 > a1){
+            for(uint32_t i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        }
+        else{
+            for(uint32_t i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for(uint32_t i = 0; i < 6; i++) indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+        for(uint32_t i = 0; i < 16; i++) texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+    }
+
+    bool decode_blocks(BLOCK_FORMAT format, const uint8_t* blocks, int32_t width, int32_t height, std::vector<uint8_t>& rgba){
+        if(format == BLOCK_NONE || format == BLOCK_BC7) return false;
+
+        rgba.assign(static_cast<size_t>(width) * height * 4, 0);
+        const int32_t blocks_x = std::max(1, (width + 3) / 4), blocks_y = std::max(1, (height + 3) / 4);
+        const uint32_t stride = block_bytes(format);
+
+        for(int32_t by = 0; by < blocks_y; by++){
+            for(int32_t bx = 0; bx < blocks_x; bx++){
+                const uint8_t* block = blocks + (static_cast<size_t>(by) * blocks_x + bx) * stride;
+                uint8_t texels[16][4]{};
+
+                switch(format){
+                    case BLOCK_BC1:
+                    case BLOCK_BC1A:
+                        decode_color(block, false, format == BLOCK_BC1A, texels);
+                        break;
+                    case BLOCK_BC2:
+                        decode_color(block + 8, true, false, texels);
+                        for(uint32_t i = 0; i < 16; i++) texels[i][3] = static_cast<uint8_t>(((block[i / 2] >> (4 * (i % 2))) & 0xF) * 17);
+                        break;
+                    case BLOCK_BC3:
+                        decode_color(block + 8, true, false, texels);
+                        decode_channel(block, texels, 3);
+                        break;
+                    case BLOCK_BC4:
+                        decode_channel(block, texels, 0);
+                        for(auto& texel : texels) texel[3] = 255;
+                        break;
+                    case BLOCK_BC5:
+                        decode_channel(block, texels, 0);
+                        decode_channel(block + 8, texels, 1);
+                        for(auto& texel : texels) texel[3] = 255;
+                        break;
+                    default:
+                        return false;
+                }
+
+                for(int32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                    for(int32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+                        std::memcpy(&rgba[((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4], texels[y * 4 + x], 4);
+            }
+        }
+        return true;
+    }
+}
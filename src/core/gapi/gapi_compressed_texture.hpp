@@ -0,0 +1,73 @@
+#pragma once
+
+#include "gapi.hpp"
+
+namespace gapi{
+
+    // Block compressed formats read from DDS and KTX2 containers. Every format stores 4x4 texel blocks.
+    enum BLOCK_FORMAT : uint32_t{
+        BLOCK_NONE  = 0,
+        BLOCK_BC1   = 1,    // RGB, 8 bytes per block
+        BLOCK_BC1A  = 2,    // RGB with 1-bit alpha, 8 bytes per block
+        BLOCK_BC2   = 3,    // RGB with explicit 4-bit alpha, 16 bytes per block
+        BLOCK_BC3   = 4,    // RGB with interpolated alpha, 16 bytes per block
+        BLOCK_BC4   = 5,    // R, 8 bytes per block
+        BLOCK_BC5   = 6,    // RG, 16 bytes per block
+        BLOCK_BC7   = 7     // RGBA, 16 bytes per block, no CPU decoder
+    };
+
+    [[nodiscard]] inline constexpr uint32_t block_bytes(BLOCK_FORMAT format){
+        switch(format){
+            case BLOCK_BC1: case BLOCK_BC1A: case BLOCK_BC4: return 8;
+            case BLOCK_BC2: case BLOCK_BC3: case BLOCK_BC5: case BLOCK_BC7: return 16;
+            default: return 0;
+        }
+    }
+
+    [[nodiscard]] inline constexpr int32_t block_channels(BLOCK_FORMAT format){
+        switch(format){
+            case BLOCK_BC1: return 3;
+            case BLOCK_BC4: return 1;
+            case BLOCK_BC5: return 2;
+            default: return 4;
+        }
+    }
+
+    // Largest width or height accepted from a container, the GL 4.x minimum for GL_MAX_TEXTURE_SIZE.
+    inline constexpr int32_t max_block_dimension = 16384;
+
+    [[nodiscard]] inline constexpr uint64_t block_level_size(BLOCK_FORMAT format, int32_t width, int32_t height){
+        return static_cast<uint64_t>(std::max(1, (width + 3) / 4)) * static_cast<uint64_t>(std::max(1, (height + 3) / 4)) * block_bytes(format);
+    }
+
+    // Texels are stored as in the file, top row first; no vertical flip is applied.
+    struct compressed_image{
+        struct level{
+            int32_t width{0};
+            int32_t height{0};
+            size_t offset{0};
+            size_t size{0};
+        };
+
+        BLOCK_FORMAT format{BLOCK_NONE};
+        bool srgb{false};
+        int32_t width{0};
+        int32_t height{0};
+        std::vector<level> levels{};
+        std::vector<uint8_t> data{};
+
+        [[nodiscard]] inline bool valid() const { return format != BLOCK_NONE && !levels.empty(); }
+        [[nodiscard]] inline const uint8_t* blocks(size_t level) const { return data.data() + levels[level].offset; }
+    };
+
+    // True when the file starts with a DDS or KTX2 signature.
+    [[nodiscard]] bool compressed_container(const std::filesystem::path& path);
+
+    // Reads 2D BCn data with all its mip levels. Cube maps, arrays, supercompressed KTX2 and
+    // formats other than BC1-BC5 and BC7 are rejected with a debug message.
+    [[nodiscard]] bool load_compressed(const std::filesystem::path& path, compressed_image& image);
+
+    // CPU fallback for drivers without the format: expands one level to tightly packed RGBA8.
+    // BC4 decodes to (r, 0, 0, 255) and BC5 to (r, g, 0, 255), as GL samples those formats.
+    [[nodiscard]] bool decode_blocks(BLOCK_FORMAT format, const uint8_t* blocks, int32_t width, int32_t height, std::vector<uint8_t>& rgba);
+}
@@ -0,0 +1,66 @@
+#include "gapi_framebuffer_pool.hpp"
+
+namespace gapi::renderer{
+
+    framebuffer_pool::framebuffer_pool(framebuffer_factory framebuffers, attachment_factory attachments, uint32_t idle_frames)
+        : m_framebuffer_factory(std::move(framebuffers)), m_attachment_factory(std::move(attachments)), m_idle_frames(idle_frames){
+        gapi_asserts(m_framebuffer_factory != nullptr && m_attachment_factory != nullptr, "Framebuffer pool needs both factories");
+    }
+
+    std::shared_ptr<framebuffer> framebuffer_pool::acquire(const framebuffer_spec& spec){
+        for(auto& entry : m_framebuffers){
+            if(entry.object.use_count() > 1 || entry.object->spec() != spec) continue;
+            entry.last_used = m_frame;
+            m_reuses++;
+            return entry.object;
+        }
+
+        auto created = m_framebuffer_factory(spec, [this](ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+            return attachment(format, width, height);
+        });
+        m_framebuffers.push_back({created, m_frame});
+        m_allocations++;
+        m_frame_allocations++;
+        return created;
+    }
+
+    std::shared_ptr<texture> framebuffer_pool::attachment(ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+        for(auto& entry : m_attachments){
+            if(entry.object.use_count() > 1 || entry.format != format) continue;
+            if(entry.object->width() != width || entry.object->height() != height) continue;
+            entry.last_used = m_frame;
+            m_reuses++;
+            return entry.object;
+        }
+
+        auto created = m_attachment_factory(format, width, height);
+        m_attachments.push_back({created, format, m_frame});
+        m_allocations++;
+        m_frame_allocations++;
+        return created;
+    }
+
+    // Framebuffers go first so the attachments they release are seen as free right away.
+    void framebuffer_pool::end_frame(){
+        auto idle = [this](auto& entry){
+            if(entry.object.use_count() > 1) entry.last_used = m_frame;
+            return m_frame - entry.last_used >= m_idle_frames;
+        };
+        std::erase_if(m_framebuffers, idle);
+        std::erase_if(m_attachments, idle);
+
+        m_last_frame_allocations = m_frame_allocations;
+        m_frame_allocations = 0;
+        m_frame++;
+    }
+
+    framebuffer_pool_stats framebuffer_pool::stats() const{
+        framebuffer_pool_stats result{};
+        result.framebuffers = static_cast<uint32_t>(m_framebuffers.size());
+        result.attachments = static_cast<uint32_t>(m_attachments.size());
+        result.allocations = m_allocations;
+        result.frame_allocations = m_last_frame_allocations;
+        result.reuses = m_reuses;
+        return result;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "gapi.hpp"
+
+namespace gapi::renderer{
+
+    struct framebuffer_pool_stats{
+        uint32_t framebuffers{0};
+        uint32_t attachments{0};
+        uint32_t allocations{0};
+        // Framebuffers and attachments created between the last two end_frame() calls.
+        uint32_t frame_allocations{0};
+        uint32_t reuses{0};
+    };
+
+    // Hands out framebuffers for transient render targets. Whatever the pool created is free again
+    // once the pool holds the only reference, so callers just drop their shared_ptr.
+    //
+    // acquire() returns a free framebuffer of the same spec when there is one. Otherwise it builds
+    // a new framebuffer whose attachments are free pooled textures of the same format and size,
+    // allocating only what can't be matched. Pooled framebuffers take their attachments from the
+    // pool on resize() as well, and give the old ones back. Entries left free for idle_frames
+    // calls to end_frame() are released. The pool must outlive the framebuffers it hands out.
+    class framebuffer_pool{
+
+        public:
+            framebuffer_pool(framebuffer_factory framebuffers, attachment_factory attachments, uint32_t idle_frames = 3);
+            framebuffer_pool(const framebuffer_pool&) = delete;
+            framebuffer_pool& operator=(const framebuffer_pool&) = delete;
+            ~framebuffer_pool() = default;
+
+            [[nodiscard]] std::shared_ptr<framebuffer> acquire(const framebuffer_spec& spec);
+            void end_frame();
+            [[nodiscard]] framebuffer_pool_stats stats() const;
+
+        private:
+            struct framebuffer_entry{
+                std::shared_ptr<framebuffer> object{nullptr};
+                uint64_t last_used{0};
+            };
+
+            struct attachment_entry{
+                std::shared_ptr<texture> object{nullptr};
+                ATTACHMENT_FORMAT format{ATTACHMENT_NONE};
+                uint64_t last_used{0};
+            };
+
+            std::shared_ptr<texture> attachment(ATTACHMENT_FORMAT format, int32_t width, int32_t height);
+
+        private:
+            framebuffer_factory m_framebuffer_factory{};
+            attachment_factory m_attachment_factory{};
+            uint32_t m_idle_frames{0};
+            uint64_t m_frame{0};
+            std::vector<framebuffer_entry> m_framebuffers{};
+            std::vector<attachment_entry> m_attachments{};
+            uint32_t m_allocations{0};
+            uint32_t m_frame_allocations{0};
+            uint32_t m_last_frame_allocations{0};
+            uint32_t m_reuses{0};
+    };
+}
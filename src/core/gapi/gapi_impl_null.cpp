@@ -0,0 +1,440 @@
+#include "gapi_impl_null.hpp"
+#include "gapi_renderer.hpp"
+#include "gapi_compressed_texture.hpp"
+
+#include <stb_image.h>
+
+namespace gapi::null{
+
+    static counters s_counters{};
+    static uint32_t s_next_handle{1};
+
+    counters& stats() noexcept{
+        return s_counters;
+    }
+
+    void reset_stats() noexcept{
+        int64_t alive = s_counters.resources_alive;
+        s_counters = {};
+        s_counters.resources_alive = alive;
+    }
+
+    bool context::init(){
+        m_info = std::make_shared<gapi::null::info>();
+        return true;
+    }
+
+    resource::resource() : m_id(s_next_handle++){
+        s_counters.resources_alive++;
+    }
+
+    resource::~resource(){
+        s_counters.resources_alive--;
+    }
+
+    vertex_buffer::vertex_buffer(float* v, uint32_t s) : m_size(s){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+        s_counters.bytes_uploaded += s;
+    }
+
+    vertex_buffer::vertex_buffer(uint32_t s) : m_size(s){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+    }
+
+    void vertex_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void vertex_buffer::set_data(const void* data, uint32_t size){
+        gapi_asserts(size <= m_size, "Vertex data exceeds buffer size");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += size;
+    }
+
+    void vertex_buffer::set_data(uint32_t offset, std::span<const std::byte> data){
+        gapi_asserts(offset + data.size() <= m_size, "Vertex data exceeds buffer size");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += data.size();
+    }
+
+    void vertex_buffer::orphan(std::span<const std::byte> data){
+        gapi_asserts(data.size() <= m_size, "Vertex data exceeds buffer size");
+        s_counters.binds++;
+        s_counters.buffer_orphans++;
+        s_counters.bytes_uploaded += data.size();
+    }
+
+    void vertex_buffer::resize(uint32_t size){
+        if(size == m_size) return;
+        m_size = size;
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+    }
+
+    stream_buffer::stream_buffer(uint32_t frame_size, uint32_t frames)
+        : m_storage(static_cast<size_t>(frame_size) * frames), m_frame_size(frame_size), m_frames(frames){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+    }
+
+    void stream_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void stream_buffer::set_data(const void* data, uint32_t size){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    void stream_buffer::set_data(uint32_t offset, std::span<const std::byte> data){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    void stream_buffer::orphan(std::span<const std::byte> data){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    void stream_buffer::begin_frame(){
+        m_frame = (m_frame + 1) % m_frames;
+        m_cursor = 0;
+    }
+
+    stream_allocation stream_buffer::reserve(uint32_t size, uint32_t alignment){
+        gapi_asserts(size <= m_frame_size, "Stream allocation is larger than a frame region");
+        uint32_t region = m_frame * m_frame_size;
+        uint32_t offset = (region + m_cursor + alignment - 1) / alignment * alignment;
+        if(offset + size > region + m_frame_size){
+            begin_frame();
+            region = m_frame * m_frame_size;
+            offset = (region + alignment - 1) / alignment * alignment;
+        }
+
+        m_cursor = offset - region;
+        return {m_storage.data() + offset, offset, size};
+    }
+
+    void stream_buffer::commit(uint32_t size){
+        m_cursor += size;
+        s_counters.bytes_uploaded += size;
+    }
+
+    uint32_t stream_buffer::remaining(uint32_t alignment) const{
+        const uint32_t region = m_frame * m_frame_size;
+        const uint32_t offset = (region + m_cursor + alignment - 1) / alignment * alignment;
+        return offset < region + m_frame_size ? region + m_frame_size - offset : 0;
+    }
+
+    index_buffer::index_buffer(uint32_t* i, size_t c, INDEX type)
+        : m_count(static_cast<uint32_t>(c)), m_capacity(static_cast<uint32_t>(c)), m_type(type){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+        if(i != nullptr) s_counters.bytes_uploaded += c * m_type;
+    }
+
+    index_buffer::index_buffer(uint16_t* i, size_t c)
+        : m_count(static_cast<uint32_t>(c)), m_capacity(static_cast<uint32_t>(c)), m_type(INDEX_U16){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+        if(i != nullptr) s_counters.bytes_uploaded += c * m_type;
+    }
+
+    void index_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void index_buffer::set_data(uint32_t offset, std::span<const uint32_t> indices){
+        const uint32_t end = offset + static_cast<uint32_t>(indices.size());
+        gapi_asserts(end <= m_capacity, "Index data exceeds buffer capacity");
+        gapi_asserts(m_type == INDEX_U32 || index_type_for(indices) == INDEX_U16, "Index does not fit a 16-bit index buffer");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += indices.size() * m_type;
+        m_count = std::max(m_count, end);
+    }
+
+    void index_buffer::orphan(std::span<const uint32_t> indices){
+        gapi_asserts(indices.size() <= m_capacity, "Index data exceeds buffer capacity");
+        gapi_asserts(m_type == INDEX_U32 || index_type_for(indices) == INDEX_U16, "Index does not fit a 16-bit index buffer");
+        s_counters.binds++;
+        s_counters.buffer_orphans++;
+        s_counters.bytes_uploaded += indices.size() * m_type;
+        m_count = static_cast<uint32_t>(indices.size());
+    }
+
+    void index_buffer::resize(uint32_t count){
+        if(count == m_capacity) return;
+        m_capacity = count;
+        m_count = 0;
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+    }
+
+    // Bound once to create its store and once to its binding point.
+    uniform_buffer::uniform_buffer(uint32_t s, uint32_t binding) : m_size(s), m_binding(binding){
+        s_counters.binds += 2;
+        s_counters.buffer_allocations++;
+    }
+
+    void uniform_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void uniform_buffer::set_data(const void* data, uint32_t size, uint32_t offset){
+        gapi_asserts(offset + size <= m_size, "Uniform data exceeds buffer size");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += size;
+    }
+
+    void indirect_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void indirect_buffer::set_data(std::span<const draw_indirect_command> commands){
+        const uint32_t count = static_cast<uint32_t>(commands.size());
+        if(count > m_capacity){
+            m_capacity = std::max(count, m_capacity * 2);
+            s_counters.buffer_allocations++;
+        }
+        else s_counters.buffer_orphans++;
+        s_counters.binds++;
+        s_counters.bytes_uploaded += commands.size_bytes();
+    }
+
+    storage_buffer::storage_buffer(uint32_t s, uint32_t binding) : m_size(s), m_binding(binding){
+        s_counters.binds++;
+        s_counters.buffer_allocations++;
+    }
+
+    void storage_buffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void storage_buffer::set_data(const void* data, uint32_t size){
+        if(size > m_size){
+            m_size = std::max(size, m_size * 2);
+            s_counters.buffer_allocations++;
+        }
+        else s_counters.buffer_orphans++;
+        s_counters.binds++;
+        s_counters.bytes_uploaded += size;
+    }
+
+    void vertex_array::bind() const{
+        s_counters.binds++;
+    }
+
+    void vertex_array::emplace_vertex(const std::shared_ptr<gapi::vertex_buffer>& vb){
+        vb->bind();
+        m_vertex_buffers.emplace_back(vb);
+    }
+
+    void vertex_array::emplace_index(const std::shared_ptr<gapi::index_buffer>& ib){
+        ib->bind();
+        m_index_buffer = ib;
+    }
+
+    void shader::bind() const{
+        s_counters.binds++;
+    }
+
+    bool shader::set(uniform_handle h) const{
+        if(!h.valid()) return false;
+        s_counters.uniform_sets++;
+        return true;
+    }
+
+    texture_2d::texture_2d(std::filesystem::path path){
+        s_counters.binds++;
+        if(compressed_container(path)){
+            compressed_image image{};
+            if(!load_compressed(path, image)) return;
+            m_width = image.width;
+            m_height = image.height;
+            m_channels = block_channels(image.format);
+            for(const auto& level : image.levels) s_counters.bytes_uploaded += level.size;
+            return;
+        }
+        if(!stbi_info(path.string().c_str(), &m_width, &m_height, &m_channels)){
+            gapi_debug_msg("Failed to read texture header: ", path.string());
+            return;
+        }
+        s_counters.bytes_uploaded += static_cast<uint64_t>(m_width) * m_height * m_channels;
+    }
+
+    texture_2d::texture_2d(int32_t width, int32_t height, int32_t channels)
+        : m_width(width), m_height(height), m_channels(channels){
+        s_counters.binds++;
+        s_counters.bytes_uploaded += static_cast<uint64_t>(m_width) * m_height * m_channels;
+    }
+
+    void texture_2d::bind(uint32_t slot) const{
+        s_counters.binds++;
+    }
+
+    void texture_2d::set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels){
+        gapi_asserts(x + width <= m_width && y + height <= m_height, "Texture data exceeds texture size");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += static_cast<uint64_t>(width) * height * m_channels;
+    }
+
+    texture_2d_array::texture_2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels)
+        : m_width(width), m_height(height), m_channels(channels), m_layers(layers){
+        s_counters.binds++;
+        s_counters.bytes_uploaded += static_cast<uint64_t>(m_width) * m_height * m_channels * m_layers;
+    }
+
+    void texture_2d_array::bind(uint32_t slot) const{
+        s_counters.binds++;
+    }
+
+    void texture_2d_array::set_layer(uint32_t layer, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels){
+        gapi_asserts(layer < m_layers && x + width <= m_width && y + height <= m_height, "Texture data exceeds texture array size");
+        s_counters.binds++;
+        s_counters.bytes_uploaded += static_cast<uint64_t>(width) * height * m_channels;
+    }
+
+    render_texture::render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height)
+        : m_width(width), m_height(height), m_format(format){
+        s_counters.binds++;
+    }
+
+    void render_texture::bind(uint32_t slot) const{
+        s_counters.binds++;
+    }
+
+    framebuffer::framebuffer(const framebuffer_spec& spec, attachment_factory factory) : m_spec(spec), m_factory(std::move(factory)){
+        if(m_factory == nullptr) m_factory = [](ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+            return std::make_shared<render_texture>(format, width, height);
+        };
+        attach();
+    }
+
+    void framebuffer::bind() const{
+        s_counters.binds++;
+    }
+
+    void framebuffer::unbind() const{
+        s_counters.binds++;
+    }
+
+    void framebuffer::resize(int32_t width, int32_t height){
+        if(width <= 0 || height <= 0 || (width == m_spec.width && height == m_spec.height)) return;
+        m_spec.width = width;
+        m_spec.height = height;
+        attach();
+    }
+
+    void framebuffer::attach(){
+        m_colors.clear();
+        m_depth = nullptr;
+        for(ATTACHMENT_FORMAT format : m_spec.colors)
+            m_colors.push_back(m_factory(format, m_spec.width, m_spec.height));
+        if(m_spec.depth != ATTACHMENT_NONE)
+            m_depth = m_factory(m_spec.depth, m_spec.width, m_spec.height);
+    }
+
+    void api::draw(const std::shared_ptr<gapi::vertex_array>& va){
+        s_counters.draws++;
+    }
+
+    void api::draw(const gapi::vertex_array& va, uint32_t count){
+        s_counters.draws++;
+    }
+
+    void api::draw(const gapi::vertex_array& va, uint32_t count, uint32_t base_vertex){
+        s_counters.draws++;
+    }
+
+    void api::draw_instanced(const gapi::vertex_array& va, uint32_t instance_count){
+        s_counters.draws++;
+        s_counters.instances += instance_count;
+    }
+
+    void api::draw_indirect(const gapi::vertex_array& va, const gapi::indirect_buffer& commands, uint32_t first, uint32_t draw_count){
+        gapi_asserts(first + draw_count <= commands.capacity(), "Indirect draw range exceeds the command buffer");
+        commands.bind();
+        s_counters.draws++;
+        s_counters.indirect_commands += draw_count;
+    }
+
+    void api::draw(const gapi::vertex_array& va, const draw_indirect_command& command){
+        s_counters.draws++;
+        s_counters.instances += command.instance_count;
+    }
+
+    std::shared_ptr<context> make_context() noexcept{
+        return std::make_shared<context>();
+    }
+
+    std::shared_ptr<vertex_buffer> make_vertex(float* v, uint32_t s) noexcept{
+        return std::make_shared<vertex_buffer>(v, s);
+    }
+
+    std::shared_ptr<vertex_buffer> make_vertex(uint32_t s) noexcept{
+        return std::make_shared<vertex_buffer>(s);
+    }
+
+    std::shared_ptr<stream_buffer> make_stream(uint32_t frame_size, uint32_t frames) noexcept{
+        return std::make_shared<stream_buffer>(frame_size, frames);
+    }
+
+    std::shared_ptr<index_buffer> make_index(uint32_t* i, size_t c) noexcept{
+        const INDEX type = i != nullptr ? index_type_for({i, c}) : INDEX_U32;
+        return std::make_shared<index_buffer>(i, c, type);
+    }
+
+    std::shared_ptr<index_buffer> make_index(uint16_t* i, size_t c) noexcept{
+        return std::make_shared<index_buffer>(i, c);
+    }
+
+    std::shared_ptr<uniform_buffer> make_uniform(uint32_t s, uint32_t binding) noexcept{
+        return std::make_shared<uniform_buffer>(s, binding);
+    }
+
+    std::shared_ptr<indirect_buffer> make_indirect() noexcept{
+        return std::make_shared<indirect_buffer>();
+    }
+
+    std::shared_ptr<storage_buffer> make_storage(uint32_t s, uint32_t binding) noexcept{
+        return std::make_shared<storage_buffer>(s, binding);
+    }
+
+    std::shared_ptr<vertex_array> make_array() noexcept{
+        return std::make_shared<vertex_array>();
+    }
+
+    std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path) noexcept{
+        return std::make_shared<texture_2d>(path);
+    }
+
+    std::shared_ptr<texture_2d> make_texture2d(int32_t width, int32_t height, int32_t channels) noexcept{
+        return std::make_shared<texture_2d>(width, height, channels);
+    }
+
+    std::shared_ptr<texture_2d_array> make_texture2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels) noexcept{
+        return std::make_shared<texture_2d_array>(width, height, layers, channels);
+    }
+
+    std::shared_ptr<render_texture> make_render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height) noexcept{
+        return std::make_shared<render_texture>(format, width, height);
+    }
+
+    std::shared_ptr<framebuffer> make_framebuffer(const framebuffer_spec& spec, attachment_factory factory) noexcept{
+        return std::make_shared<framebuffer>(spec, std::move(factory));
+    }
+
+    std::shared_ptr<shader> make_shader(const std::string& sname) noexcept{
+        return std::make_shared<shader>(sname);
+    }
+
+    gapi::shader_factory make_shader_factory() noexcept{
+        return [](const std::string& name, const std::filesystem::path& path, const shader_defines& defines) -> std::shared_ptr<gapi::shader> {
+            return make_shader(name);
+        };
+    }
+}
+
+namespace gapi::renderer{
+
+    template class gapi_render<gnull::api>;
+}
@@ -0,0 +1,412 @@
+#pragma once
+
+#include "gapi.hpp"
+
+// Headless backend: implements every gapi interface without touching a GPU and
+// keeps exact counters of the work the OpenGL backend would have issued.
+namespace gapi::null{
+
+    // binds counts every bind the OpenGL backend issues through its state cache, those made by
+    // constructors and updates included. Re-specifying a buffer store at its size is an orphan.
+    struct counters{
+        uint64_t draws{0};
+        uint64_t instances{0};
+        uint64_t indirect_commands{0};
+        uint64_t binds{0};
+        uint64_t uniform_sets{0};
+        uint64_t bytes_uploaded{0};
+        uint64_t buffer_allocations{0};
+        uint64_t buffer_orphans{0};
+        int64_t resources_alive{0};
+    };
+
+    [[nodiscard]] counters& stats() noexcept;
+    void reset_stats() noexcept;
+
+    class info final : public gapi::info{
+
+        public:
+            info() = default;
+            virtual ~info() = default;
+
+            inline virtual const std::string& vendor() const override   { return m_vendor;   }
+            inline virtual const std::string& renderer() const override { return m_renderer; }
+            inline virtual const std::string& version() const override  { return m_version;  }
+            inline virtual const std::string& language() const override { return m_language; }
+
+        private:
+            std::string m_vendor{"trimana"};
+            std::string m_renderer{"null"};
+            std::string m_version{"0.0.0"};
+            std::string m_language{"none"};
+    };
+
+    class context final : public gapi::context{
+
+        public:
+            context() = default;
+            virtual ~context() = default;
+
+            virtual bool init() override;
+            virtual void swap() override {}
+            virtual void interval(uint32_t interval) override {}
+            inline const std::shared_ptr<gapi::null::info>& info() const { return m_info; }
+
+        private:
+            std::shared_ptr<gapi::null::info> m_info{nullptr};
+    };
+
+    class resource{
+
+        protected:
+            resource();
+            resource(const resource&) = delete;
+            resource& operator=(const resource&) = delete;
+            ~resource();
+
+            inline uint32_t resource_id() const { return m_id; }
+
+        private:
+            uint32_t m_id{0};
+    };
+
+    class vertex_buffer final : public gapi::vertex_buffer, private resource {
+
+        public:
+            vertex_buffer(float* v, uint32_t s);
+            vertex_buffer(uint32_t s);
+            virtual ~vertex_buffer() = default;
+
+            using gapi::vertex_buffer::set_data;
+            using gapi::vertex_buffer::orphan;
+            virtual void bind() const override;
+            virtual void unbind() const override {}
+            virtual void set_data(const void* data, uint32_t size) override;
+            virtual void set_data(uint32_t offset, std::span<const std::byte> data) override;
+            virtual void orphan(std::span<const std::byte> data) override;
+            virtual void resize(uint32_t size) override;
+            inline virtual uint32_t size() const override { return m_size; }
+            virtual void configure_layout(const gapi::buffer_layout& layout) override { m_layout = layout; };
+            virtual const gapi::buffer_layout& layout() const override { return m_layout; };
+
+        private:
+            uint32_t m_size{0};
+            gapi::buffer_layout m_layout{};
+    };
+
+    class stream_buffer final : public gapi::stream_buffer, private resource {
+
+        public:
+            stream_buffer(uint32_t frame_size, uint32_t frames);
+            virtual ~stream_buffer() = default;
+
+            using gapi::vertex_buffer::set_data;
+            using gapi::vertex_buffer::orphan;
+            virtual void bind() const override;
+            virtual void unbind() const override {}
+            virtual void set_data(const void* data, uint32_t size) override;
+            virtual void set_data(uint32_t offset, std::span<const std::byte> data) override;
+            virtual void orphan(std::span<const std::byte> data) override;
+            virtual void resize(uint32_t size) override { gapi_asserts(size == this->size(), "Stream buffers use immutable storage and cannot be resized"); }
+            inline virtual uint32_t size() const override { return m_frame_size * m_frames; }
+            virtual void configure_layout(const gapi::buffer_layout& layout) override { m_layout = layout; };
+            virtual const gapi::buffer_layout& layout() const override { return m_layout; };
+
+            virtual void begin_frame() override;
+            virtual void end_frame() override {}
+            virtual stream_allocation reserve(uint32_t size, uint32_t alignment) override;
+            virtual void commit(uint32_t size) override;
+            virtual uint32_t remaining(uint32_t alignment) const override;
+
+            inline virtual uint32_t frame_size() const override { return m_frame_size; }
+            inline virtual uint32_t frames() const override { return m_frames; }
+            inline virtual uint32_t stalls() const override { return 0; }
+
+        private:
+            std::vector<uint8_t> m_storage{};
+            uint32_t m_frame_size{0};
+            uint32_t m_frames{0};
+            uint32_t m_frame{0};
+            uint32_t m_cursor{0};
+            gapi::buffer_layout m_layout{};
+    };
+
+    class index_buffer final : public gapi::index_buffer, private resource {
+
+        public:
+            index_buffer(uint32_t* i, size_t c, INDEX type = INDEX_U32);
+            index_buffer(uint16_t* i, size_t c);
+            virtual ~index_buffer() = default;
+
+            void bind() const override;
+            void unbind() const override {}
+            inline uint32_t count() const override { return m_count; }
+            inline INDEX type() const override { return m_type; }
+
+            virtual void set_data(uint32_t offset, std::span<const uint32_t> indices) override;
+            virtual void orphan(std::span<const uint32_t> indices) override;
+            virtual void resize(uint32_t count) override;
+            inline virtual uint32_t capacity() const override { return m_capacity; }
+
+        private:
+            uint32_t m_count{0};
+            uint32_t m_capacity{0};
+            INDEX m_type{INDEX_U32};
+    };
+
+    class uniform_buffer final : public gapi::uniform_buffer, private resource {
+
+        public:
+            uniform_buffer(uint32_t s, uint32_t binding);
+            virtual ~uniform_buffer() = default;
+
+            using gapi::uniform_buffer::set_data;
+            virtual void bind() const override;
+            virtual void set_data(const void* data, uint32_t size, uint32_t offset = 0) override;
+            inline virtual uint32_t binding() const override { return m_binding; }
+            inline virtual uint32_t size() const override { return m_size; }
+
+        private:
+            uint32_t m_size{0};
+            uint32_t m_binding{0};
+    };
+
+    class indirect_buffer final : public gapi::indirect_buffer, private resource {
+
+        public:
+            indirect_buffer() = default;
+            virtual ~indirect_buffer() = default;
+
+            virtual void bind() const override;
+            virtual void unbind() const override {}
+            virtual void set_data(std::span<const draw_indirect_command> commands) override;
+            inline virtual uint32_t capacity() const override { return m_capacity; }
+
+        private:
+            uint32_t m_capacity{0};
+    };
+
+    class storage_buffer final : public gapi::storage_buffer, private resource {
+
+        public:
+            storage_buffer(uint32_t s, uint32_t binding);
+            virtual ~storage_buffer() = default;
+
+            virtual void bind() const override;
+            virtual void set_data(const void* data, uint32_t size) override;
+            inline virtual uint32_t binding() const override { return m_binding; }
+            inline virtual uint32_t size() const override { return m_size; }
+
+        private:
+            uint32_t m_size{0};
+            uint32_t m_binding{0};
+    };
+
+    class vertex_array final : public gapi::vertex_array, private resource {
+
+        public:
+            vertex_array() = default;
+            virtual ~vertex_array() = default;
+
+            void bind() const override;
+            void unbind() const override {}
+            inline uint32_t id() const override { return resource_id(); }
+            void emplace_vertex(const std::shared_ptr<gapi::vertex_buffer>& vb) override;
+            void emplace_index(const std::shared_ptr<gapi::index_buffer>& ib) override;
+            inline const std::vector<std::shared_ptr<gapi::vertex_buffer>>& vertexs() const override { return m_vertex_buffers; }
+            inline const std::shared_ptr<gapi::index_buffer>& index() const override { return m_index_buffer; }
+
+        private:
+            std::vector<std::shared_ptr<gapi::vertex_buffer>> m_vertex_buffers{};
+            std::shared_ptr<gapi::index_buffer> m_index_buffer{};
+    };
+
+    class shader final : public gapi::shader, private resource {
+
+        public:
+            shader(const std::string& sname) : m_name(sname) {}
+            virtual ~shader() = default;
+
+            void bind() const override;
+            void unbind() const override {}
+            inline virtual const std::string& name() const override { return m_name; }
+            inline virtual uint32_t id() const override { return resource_id(); }
+            virtual bool ready() const override { return true; }
+            virtual void resolve() const override {}
+            virtual const std::vector<std::filesystem::path>& sources() const override { return m_sources; }
+            virtual void reload() override {}
+            virtual bool swap() override { return false; }
+
+            using gapi::shader::uniform;
+            virtual uniform_handle handle(std::string_view n) const override { return handle(uniform_hash(n)); }
+            virtual uniform_handle handle(uniform_hash h) const override { return {static_cast<int32_t>(h.value & 0x7FFFFFFF), h.value}; }
+            virtual bool uniform(uniform_handle h, uint32_t v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, float v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, float x, float y) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, float x, float y, float z) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, float x, float y, float z, float w) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::vec2& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::vec3& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::vec4& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::mat2& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::mat3& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const glm::mat4& v) const override { return set(h); }
+            virtual bool uniform(uniform_handle h, const int32_t* v, uint32_t count) const override { return set(h); }
+
+        private:
+            bool set(uniform_handle h) const;
+
+        private:
+            std::string m_name{};
+            std::vector<std::filesystem::path> m_sources{};
+    };
+
+    class texture_2d final : public gapi::texture, private resource {
+
+        public:
+            texture_2d(std::filesystem::path path);
+            texture_2d(int32_t width, int32_t height, int32_t channels);
+            virtual ~texture_2d() = default;
+
+            virtual void bind(uint32_t slot = 0) const override;
+            [[maybe_unused]] virtual void unbind() const override {}
+
+            [[maybe_unused]] virtual uint32_t id() const override { return resource_id(); }
+            [[maybe_unused]] virtual int32_t width() const override { return m_width; }
+            [[maybe_unused]] virtual int32_t height() const override { return m_height; }
+            [[maybe_unused]] virtual int32_t channels() const override { return m_channels; }
+            [[maybe_unused]] virtual uint8_t* data() const override { return nullptr; }
+            virtual bool ready() const override { return true; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override;
+
+        private:
+            int32_t m_width{0};
+            int32_t m_height{0};
+            int32_t m_channels{0};
+    };
+
+    class texture_2d_array final : public gapi::texture_array, private resource {
+
+        public:
+            texture_2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels);
+            virtual ~texture_2d_array() = default;
+
+            virtual void bind(uint32_t slot = 0) const override;
+            [[maybe_unused]] virtual void unbind() const override {}
+
+            [[maybe_unused]] virtual uint32_t id() const override { return resource_id(); }
+            [[maybe_unused]] virtual int32_t width() const override { return m_width; }
+            [[maybe_unused]] virtual int32_t height() const override { return m_height; }
+            [[maybe_unused]] virtual int32_t channels() const override { return m_channels; }
+            [[maybe_unused]] virtual uint8_t* data() const override { return nullptr; }
+            virtual bool ready() const override { return true; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override { set_layer(0, x, y, width, height, pixels); }
+            virtual uint32_t layers() const override { return m_layers; }
+            virtual void set_layer(uint32_t layer, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override;
+
+        private:
+            int32_t m_width{0};
+            int32_t m_height{0};
+            int32_t m_channels{0};
+            uint32_t m_layers{0};
+    };
+
+    class render_texture final : public gapi::texture, private resource {
+
+        public:
+            render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height);
+            virtual ~render_texture() = default;
+
+            virtual void bind(uint32_t slot = 0) const override;
+            [[maybe_unused]] virtual void unbind() const override {}
+
+            [[maybe_unused]] virtual uint32_t id() const override { return resource_id(); }
+            [[maybe_unused]] virtual int32_t width() const override { return m_width; }
+            [[maybe_unused]] virtual int32_t height() const override { return m_height; }
+            [[maybe_unused]] virtual int32_t channels() const override { return depth_format(m_format) ? 1 : 4; }
+            [[maybe_unused]] virtual uint8_t* data() const override { return nullptr; }
+            virtual bool ready() const override { return true; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override {}
+
+        private:
+            int32_t m_width{0};
+            int32_t m_height{0};
+            ATTACHMENT_FORMAT m_format{ATTACHMENT_NONE};
+    };
+
+    class framebuffer final : public gapi::framebuffer, private resource {
+
+        public:
+            framebuffer(const framebuffer_spec& spec, attachment_factory factory = nullptr);
+            virtual ~framebuffer() = default;
+
+            virtual void bind() const override;
+            virtual void unbind() const override;
+            virtual void resize(int32_t width, int32_t height) override;
+
+            [[maybe_unused]] virtual uint32_t id() const override { return resource_id(); }
+            virtual const framebuffer_spec& spec() const override { return m_spec; }
+            virtual const std::shared_ptr<gapi::texture>& color(uint32_t index = 0) const override { return m_colors[index]; }
+            virtual const std::shared_ptr<gapi::texture>& depth() const override { return m_depth; }
+
+        private:
+            void attach();
+
+        private:
+            framebuffer_spec m_spec{};
+            attachment_factory m_factory{};
+            std::vector<std::shared_ptr<gapi::texture>> m_colors{};
+            std::shared_ptr<gapi::texture> m_depth{nullptr};
+    };
+
+    // Nothing to time without a GPU.
+    class gpu_zone{
+        public:
+            explicit gpu_zone(std::string_view name) {}
+    };
+
+    class api final : public gapi::base_api {
+
+        public:
+            api() = default;
+            virtual ~api() = default;
+
+            virtual void init() override {}
+            virtual void draw(const std::shared_ptr<gapi::vertex_array>& va) override;
+            virtual void draw(const gapi::vertex_array& va, uint32_t count) override;
+            virtual void draw(const gapi::vertex_array& va, uint32_t count, uint32_t base_vertex) override;
+            virtual void draw_instanced(const gapi::vertex_array& va, uint32_t instance_count) override;
+            virtual void draw_indirect(const gapi::vertex_array& va, const gapi::indirect_buffer& commands, uint32_t first, uint32_t draw_count) override;
+            virtual void draw(const gapi::vertex_array& va, const draw_indirect_command& command) override;
+            virtual void clear() override {}
+            virtual void clear_color(float r, float g, float b, float a) override {}
+            virtual void unbind_texture(uint32_t slot) override {}
+            virtual uint32_t max_texture_slots() const override { return 32; }
+            virtual bool draw_parameters() const override { return s_draw_parameters; }
+            virtual GAPI xapi() const override { return gapi::GAPI::SYSTEM; }
+
+        public:
+            // False follows the path of drivers without gl_DrawID.
+            inline static bool s_draw_parameters{true};
+    };
+
+    [[nodiscard]] std::shared_ptr<context> make_context() noexcept;
+    [[nodiscard]] std::shared_ptr<vertex_buffer> make_vertex(float* v, uint32_t s) noexcept;
+    [[nodiscard]] std::shared_ptr<vertex_buffer> make_vertex(uint32_t s) noexcept;
+    [[nodiscard]] std::shared_ptr<stream_buffer> make_stream(uint32_t frame_size, uint32_t frames = 3) noexcept;
+    [[nodiscard]] std::shared_ptr<index_buffer> make_index(uint32_t* i, size_t c) noexcept;
+    [[nodiscard]] std::shared_ptr<index_buffer> make_index(uint16_t* i, size_t c) noexcept;
+    [[nodiscard]] std::shared_ptr<uniform_buffer> make_uniform(uint32_t s, uint32_t binding) noexcept;
+    [[nodiscard]] std::shared_ptr<indirect_buffer> make_indirect() noexcept;
+    [[nodiscard]] std::shared_ptr<storage_buffer> make_storage(uint32_t s, uint32_t binding) noexcept;
+    [[nodiscard]] std::shared_ptr<vertex_array> make_array() noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d> make_texture2d(int32_t width, int32_t height, int32_t channels) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d_array> make_texture2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels) noexcept;
+    [[nodiscard]] std::shared_ptr<render_texture> make_render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height) noexcept;
+    [[nodiscard]] std::shared_ptr<framebuffer> make_framebuffer(const framebuffer_spec& spec, attachment_factory factory = nullptr) noexcept;
+    [[nodiscard]] std::shared_ptr<shader> make_shader(const std::string& sname) noexcept;
+    [[nodiscard]] gapi::shader_factory make_shader_factory() noexcept;
+}
+
+namespace gnull = gapi::null;
@@ -1,5 +1,9 @@
 #include "gapi_impl_opengl.hpp"
 
+#include <stb_image_write.h>
+#include <iomanip>
+#include <utility>
+
 #ifdef _DEBUG
 #include <iostream>
 struct gl_error_message{
@@ -93,6 +97,11 @@ namespace gapi::opengl{
         GLenum status = glewInit();
         gapi_asserts(status != GLEW_OK, "Failed to initialize GLEW");
 
+        // Let the driver pick how many threads compile shaders in the background.
+        shader::s_parallel_compile = GLEW_KHR_parallel_shader_compile;
+        if(shader::s_parallel_compile) gl(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+
+        state_cache::invalidate();
         m_info = std::make_shared<gapi::opengl::info>();
         return true;
     }
@@ -107,69 +116,533 @@ namespace gapi::opengl{
         glfwSwapInterval(interval);
     }
 
-    vertex_buffer::vertex_buffer(float * v, uint32_t s, DRAW t){
+    static int32_t buffer_target(GLenum target){
+        switch(target){
+            case GL_ARRAY_BUFFER:           return 0;
+            case GL_ELEMENT_ARRAY_BUFFER:   return 1;
+            case GL_UNIFORM_BUFFER:         return 2;
+            case GL_SHADER_STORAGE_BUFFER:  return 3;
+            case GL_DRAW_INDIRECT_BUFFER:   return 4;
+            case GL_PIXEL_UNPACK_BUFFER:    return 5;
+            case GL_PIXEL_PACK_BUFFER:      return 6;
+            case GL_COPY_WRITE_BUFFER:      return 7;
+            default:                        return -1;
+        }
+    }
+
+    static int32_t texture_target(GLenum target){
+        switch(target){
+            case GL_TEXTURE_2D:             return 0;
+            case GL_TEXTURE_2D_ARRAY:       return 1;
+            case GL_TEXTURE_3D:             return 2;
+            case GL_TEXTURE_CUBE_MAP:       return 3;
+            default:                        return -1;
+        }
+    }
+
+    bool state_cache::change(uint32_t& shadow, uint32_t value){
+        if(shadow == value){
+            s_stats.elided++;
+            return false;
+        }
+        shadow = value;
+        s_stats.issued++;
+        return true;
+    }
+
+    void state_cache::program(uint32_t id){
+        if(change(s_program, id)) gl(glUseProgram(id));
+    }
+
+    // The element array binding belongs to the vertex array, so it is unknown after a switch.
+    void state_cache::vertex_array(uint32_t id){
+        if(!change(s_vertex_array, id)) return;
+        gl(glBindVertexArray(id));
+        s_buffers[buffer_target(GL_ELEMENT_ARRAY_BUFFER)] = s_unknown;
+    }
+
+    void state_cache::buffer(GLenum target, uint32_t id){
+        const int32_t slot = buffer_target(target);
+        if(slot < 0){
+            s_stats.issued++;
+            gl(glBindBuffer(target, id));
+            return;
+        }
+        if(change(s_buffers[slot], id)) gl(glBindBuffer(target, id));
+    }
+
+    void state_cache::buffer_base(GLenum target, uint32_t index, uint32_t id){
+        uint32_t* bases = target == GL_UNIFORM_BUFFER ? s_uniform_bases : target == GL_SHADER_STORAGE_BUFFER ? s_storage_bases : nullptr;
+        if(bases != nullptr && index < max_indexed && !change(bases[index], id)) return;
+        if(bases == nullptr || index >= max_indexed) s_stats.issued++;
+
+        gl(glBindBufferBase(target, index, id));
+        const int32_t slot = buffer_target(target);
+        if(slot >= 0) s_buffers[slot] = id;
+    }
+
+    void state_cache::active(uint32_t unit){
+        if(change(s_active_unit, unit)) gl(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+
+    // Already bound there: the active unit doesn't need to move either.
+    void state_cache::texture(uint32_t unit, GLenum target, uint32_t id){
+        const int32_t slot = texture_target(target);
+        if(slot >= 0 && unit < max_units && s_textures[unit][slot] == id){
+            s_stats.elided++;
+            return;
+        }
+        active(unit);
+        texture(target, id);
+    }
+
+    void state_cache::texture(GLenum target, uint32_t id){
+        const int32_t slot = texture_target(target);
+        if(slot < 0 || s_active_unit >= max_units){
+            s_stats.issued++;
+            gl(glBindTexture(target, id));
+            return;
+        }
+        if(change(s_textures[s_active_unit][slot], id)) gl(glBindTexture(target, id));
+    }
+
+    void state_cache::blend(bool enabled){
+        if(!change(s_blend, enabled ? 1 : 0)) return;
+        if(enabled){
+            gl(glEnable(GL_BLEND));
+        }
+        else{
+            gl(glDisable(GL_BLEND));
+        }
+    }
+
+    void state_cache::blend_func(GLenum source, GLenum destination){
+        if(s_blend_source == source && s_blend_destination == destination){
+            s_stats.elided++;
+            return;
+        }
+        s_blend_source = source;
+        s_blend_destination = destination;
+        s_stats.issued++;
+        gl(glBlendFunc(source, destination));
+    }
+
+    void state_cache::clear_color(const glm::vec4& color){
+        if(s_clear_color_known && s_clear_color == color){
+            s_stats.elided++;
+            return;
+        }
+        s_clear_color = color;
+        s_clear_color_known = true;
+        s_stats.issued++;
+        gl(glClearColor(color.x, color.y, color.z, color.w));
+    }
+
+    void state_cache::framebuffer(uint32_t id){
+        if(change(s_framebuffer, id)) gl(glBindFramebuffer(GL_FRAMEBUFFER, id));
+    }
+
+    void state_cache::viewport(int32_t x, int32_t y, int32_t width, int32_t height){
+        const std::array<int32_t, 4> value{x, y, width, height};
+        if(s_viewport == value){
+            s_stats.elided++;
+            return;
+        }
+        s_viewport = value;
+        s_stats.issued++;
+        gl(glViewport(x, y, width, height));
+    }
+
+    void state_cache::forget_buffer(uint32_t id){
+        for(auto& bound : s_buffers)
+            if(bound == id) bound = 0;
+        for(uint32_t i = 0; i < max_indexed; i++){
+            if(s_uniform_bases[i] == id) s_uniform_bases[i] = 0;
+            if(s_storage_bases[i] == id) s_storage_bases[i] = 0;
+        }
+    }
+
+    void state_cache::forget_texture(uint32_t id){
+        for(auto& unit : s_textures)
+            for(auto& bound : unit)
+                if(bound == id) bound = 0;
+    }
+
+    void state_cache::forget_vertex_array(uint32_t id){
+        if(s_vertex_array != id) return;
+        s_vertex_array = 0;
+        s_buffers[buffer_target(GL_ELEMENT_ARRAY_BUFFER)] = s_unknown;
+    }
+
+    void state_cache::forget_framebuffer(uint32_t id){
+        if(s_framebuffer == id) s_framebuffer = 0;
+    }
+
+    void state_cache::invalidate(){
+        s_program = s_unknown;
+        s_vertex_array = s_unknown;
+        std::fill(std::begin(s_buffers), std::end(s_buffers), s_unknown);
+        std::fill(std::begin(s_uniform_bases), std::end(s_uniform_bases), s_unknown);
+        std::fill(std::begin(s_storage_bases), std::end(s_storage_bases), s_unknown);
+        s_active_unit = s_unknown;
+        for(auto& unit : s_textures) std::fill(std::begin(unit), std::end(unit), s_unknown);
+        s_blend = s_unknown;
+        s_blend_source = s_unknown;
+        s_blend_destination = s_unknown;
+        s_clear_color_known = false;
+        s_framebuffer = s_unknown;
+        s_viewport = {-1, -1, -1, -1};
+    }
+
+    vertex_buffer::vertex_buffer(float * v, uint32_t s, DRAW t) : m_size(s), m_usage(t){
         gl(glGenBuffers(1, &m_id));
-        gl(glBindBuffer(GL_ARRAY_BUFFER, m_id));
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
         gl(glBufferData(GL_ARRAY_BUFFER, s, v, static_cast<GLenum>(t)));
     }
 
+    vertex_buffer::vertex_buffer(uint32_t s, DRAW t) : m_size(s), m_usage(t){
+        gl(glGenBuffers(1, &m_id));
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferData(GL_ARRAY_BUFFER, s, nullptr, static_cast<GLenum>(t)));
+    }
+
     vertex_buffer::~vertex_buffer(){
+        state_cache::forget_buffer(m_id);
         gl(glDeleteBuffers(1, &m_id));
     }
 
     void vertex_buffer::bind() const{
-        gl(glBindBuffer(GL_ARRAY_BUFFER, m_id));
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
     }
 
     void vertex_buffer::unbind() const{
-        gl(glBindBuffer(GL_ARRAY_BUFFER, 0));
+        state_cache::buffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void vertex_buffer::set_data(const void* data, uint32_t size){
+        gapi_asserts(size <= m_size, "Vertex data exceeds buffer size");
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+    }
+
+    void vertex_buffer::set_data(uint32_t offset, std::span<const std::byte> data){
+        gapi_asserts(offset + data.size() <= m_size, "Vertex data exceeds buffer size");
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferSubData(GL_ARRAY_BUFFER, offset, data.size(), data.data()));
+    }
+
+    // Re-specifying the store with the same size and usage lets the driver hand out fresh
+    // memory while draws still reading the old contents finish; the buffer name is unchanged.
+    void vertex_buffer::orphan(std::span<const std::byte> data){
+        gapi_asserts(data.size() <= m_size, "Vertex data exceeds buffer size");
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferData(GL_ARRAY_BUFFER, m_size, nullptr, static_cast<GLenum>(m_usage)));
+        gl(glBufferSubData(GL_ARRAY_BUFFER, 0, data.size(), data.data()));
+    }
+
+    void vertex_buffer::resize(uint32_t size){
+        if(size == m_size) return;
+        m_size = size;
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferData(GL_ARRAY_BUFFER, m_size, nullptr, static_cast<GLenum>(m_usage)));
+    }
+
+    stream_buffer::stream_buffer(uint32_t frame_size, uint32_t frames) : m_frame_size(frame_size), m_fences(frames, nullptr){
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr total = static_cast<GLsizeiptr>(frame_size) * frames;
+
+        gl(glGenBuffers(1, &m_id));
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags));
+        void* mapped = gl(glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+        m_mapped = static_cast<uint8_t*>(mapped);
+        gapi_asserts(m_mapped != nullptr, "Failed to map stream buffer");
+    }
+
+    stream_buffer::~stream_buffer(){
+        for(auto& fence : m_fences){
+            if(fence != nullptr) gl(glDeleteSync(fence));
+        }
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+        gl(glUnmapBuffer(GL_ARRAY_BUFFER));
+        state_cache::forget_buffer(m_id);
+        gl(glDeleteBuffers(1, &m_id));
+    }
+
+    void stream_buffer::bind() const{
+        state_cache::buffer(GL_ARRAY_BUFFER, m_id);
+    }
+
+    void stream_buffer::unbind() const{
+        state_cache::buffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Vertex arrays read from offset 0 while the ring writes elsewhere, see gapi::stream_buffer.
+    void stream_buffer::set_data(const void* data, uint32_t size){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    void stream_buffer::set_data(uint32_t offset, std::span<const std::byte> data){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    void stream_buffer::orphan(std::span<const std::byte> data){
+        gapi_asserts(false, "Stream buffers are written through reserve() and commit()");
+    }
+
+    // Immutable storage can't be reallocated, and vertex arrays keep pointing at this buffer.
+    void stream_buffer::resize(uint32_t size){
+        gapi_asserts(size == this->size(), "Stream buffers use immutable storage and cannot be resized");
+    }
+
+    void stream_buffer::begin_frame(){
+        m_frame = (m_frame + 1) % frames();
+        if(wait(m_fences[m_frame])) m_stalls++;
+        m_cursor = 0;
+        m_reserved = 0;
+    }
+
+    void stream_buffer::end_frame(){
+        if(m_fences[m_frame] != nullptr) gl(glDeleteSync(m_fences[m_frame]));
+        m_fences[m_frame] = gl(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+
+    stream_allocation stream_buffer::reserve(uint32_t size, uint32_t alignment){
+        gapi_asserts(size <= m_frame_size, "Stream allocation is larger than a frame region");
+        const uint32_t region = m_frame * m_frame_size;
+        uint32_t offset = (region + m_cursor + alignment - 1) / alignment * alignment;
+
+        // The current region is exhausted, fence it and move on to the next one.
+        if(offset + size > region + m_frame_size){
+            advance();
+            const uint32_t next = m_frame * m_frame_size;
+            offset = (next + alignment - 1) / alignment * alignment;
+        }
+
+        m_cursor = offset - m_frame * m_frame_size;
+        m_reserved = size;
+        return {m_mapped + offset, offset, size};
+    }
+
+    void stream_buffer::commit(uint32_t size){
+        gapi_asserts(size <= m_reserved, "Committed more than was reserved");
+        m_cursor += size;
+        m_reserved = 0;
+    }
+
+    uint32_t stream_buffer::remaining(uint32_t alignment) const{
+        const uint32_t region = m_frame * m_frame_size;
+        const uint32_t offset = (region + m_cursor + alignment - 1) / alignment * alignment;
+        return offset < region + m_frame_size ? region + m_frame_size - offset : 0;
+    }
+
+    void stream_buffer::advance(){
+        end_frame();
+        m_frame = (m_frame + 1) % frames();
+        if(wait(m_fences[m_frame])) m_stalls++;
+        m_cursor = 0;
+    }
+
+    bool stream_buffer::wait(GLsync& fence){
+        if(fence == nullptr) return false;
+
+        bool blocked = false;
+        GLbitfield flags = 0;
+        GLuint64 timeout = 0;
+        while(true){
+            GLenum result = gl(glClientWaitSync(fence, flags, timeout));
+            if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) break;
+            blocked = true;
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            timeout = 1000000;
+        }
+
+        gl(glDeleteSync(fence));
+        fence = nullptr;
+        return blocked;
     }
 
-    index_buffer::index_buffer(uint32_t* i, size_t c, DRAW t){
+    // The element array binding belongs to whichever vertex array is bound, so index data is
+    // written through GL_COPY_WRITE_BUFFER and only bind() touches GL_ELEMENT_ARRAY_BUFFER.
+    index_buffer::index_buffer(uint32_t* i, size_t c, DRAW t, INDEX type)
+        : m_count(static_cast<uint32_t>(c)), m_capacity(static_cast<uint32_t>(c)), m_usage(t), m_type(type){
         gl(glGenBuffers(1, &m_id));
-        gl(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id));
-        gl(glBufferData(GL_ELEMENT_ARRAY_BUFFER, c, i, static_cast<GLenum>(t)));
+        state_cache::buffer(GL_COPY_WRITE_BUFFER, m_id);
+        gl(glBufferData(GL_COPY_WRITE_BUFFER, c * m_type, nullptr, static_cast<GLenum>(t)));
+        if(i != nullptr) write(0, {i, c});
+    }
+
+    index_buffer::index_buffer(uint16_t* i, size_t c, DRAW t)
+        : m_count(static_cast<uint32_t>(c)), m_capacity(static_cast<uint32_t>(c)), m_usage(t), m_type(INDEX_U16){
+        gl(glGenBuffers(1, &m_id));
+        state_cache::buffer(GL_COPY_WRITE_BUFFER, m_id);
+        gl(glBufferData(GL_COPY_WRITE_BUFFER, c * sizeof(uint16_t), i, static_cast<GLenum>(t)));
     }
 
     index_buffer::~index_buffer(){
+        state_cache::forget_buffer(m_id);
         gl(glDeleteBuffers(1, &m_id));
     }
 
     void index_buffer::bind() const {
-        gl(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id));
+        state_cache::buffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
     }
 
     void index_buffer::unbind() const {
-        gl(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+        state_cache::buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void index_buffer::set_data(uint32_t offset, std::span<const uint32_t> indices){
+        const uint32_t end = offset + static_cast<uint32_t>(indices.size());
+        gapi_asserts(end <= m_capacity, "Index data exceeds buffer capacity");
+        state_cache::buffer(GL_COPY_WRITE_BUFFER, m_id);
+        write(offset, indices);
+        m_count = std::max(m_count, end);
+    }
+
+    void index_buffer::orphan(std::span<const uint32_t> indices){
+        gapi_asserts(indices.size() <= m_capacity, "Index data exceeds buffer capacity");
+        state_cache::buffer(GL_COPY_WRITE_BUFFER, m_id);
+        gl(glBufferData(GL_COPY_WRITE_BUFFER, m_capacity * m_type, nullptr, static_cast<GLenum>(m_usage)));
+        write(0, indices);
+        m_count = static_cast<uint32_t>(indices.size());
+    }
+
+    void index_buffer::resize(uint32_t count){
+        if(count == m_capacity) return;
+        m_capacity = count;
+        m_count = 0;
+        state_cache::buffer(GL_COPY_WRITE_BUFFER, m_id);
+        gl(glBufferData(GL_COPY_WRITE_BUFFER, m_capacity * m_type, nullptr, static_cast<GLenum>(m_usage)));
+    }
+
+    // Expects the buffer to be bound to GL_COPY_WRITE_BUFFER.
+    void index_buffer::write(uint32_t offset, std::span<const uint32_t> indices){
+        if(m_type == INDEX_U32){
+            gl(glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(uint32_t), indices.size_bytes(), indices.data()));
+            return;
+        }
+
+        gapi_asserts(index_type_for(indices) == INDEX_U16, "Index does not fit a 16-bit index buffer");
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        gl(glBufferSubData(GL_COPY_WRITE_BUFFER, offset * sizeof(uint16_t), narrow.size() * sizeof(uint16_t), narrow.data()));
+    }
+
+    uniform_buffer::uniform_buffer(uint32_t s, uint32_t binding, DRAW t) : m_size(s), m_binding(binding){
+        gl(glGenBuffers(1, &m_id));
+        state_cache::buffer(GL_UNIFORM_BUFFER, m_id);
+        gl(glBufferData(GL_UNIFORM_BUFFER, s, nullptr, static_cast<GLenum>(t)));
+        state_cache::buffer_base(GL_UNIFORM_BUFFER, m_binding, m_id);
+    }
+
+    uniform_buffer::~uniform_buffer(){
+        state_cache::forget_buffer(m_id);
+        gl(glDeleteBuffers(1, &m_id));
+    }
+
+    void uniform_buffer::bind() const {
+        state_cache::buffer_base(GL_UNIFORM_BUFFER, m_binding, m_id);
+    }
+
+    void uniform_buffer::set_data(const void* data, uint32_t size, uint32_t offset){
+        gapi_asserts(offset + size <= m_size, "Uniform data exceeds buffer size");
+        state_cache::buffer(GL_UNIFORM_BUFFER, m_id);
+        gl(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+    }
+
+    indirect_buffer::indirect_buffer(){
+        gl(glGenBuffers(1, &m_id));
+    }
+
+    indirect_buffer::~indirect_buffer(){
+        state_cache::forget_buffer(m_id);
+        gl(glDeleteBuffers(1, &m_id));
+    }
+
+    void indirect_buffer::bind() const{
+        state_cache::buffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+    }
+
+    void indirect_buffer::unbind() const{
+        state_cache::buffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // Commands are rebuilt every frame, so the store is always re-specified before the write.
+    void indirect_buffer::set_data(std::span<const draw_indirect_command> commands){
+        const uint32_t count = static_cast<uint32_t>(commands.size());
+        if(count > m_capacity) m_capacity = std::max(count, m_capacity * 2);
+
+        state_cache::buffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+        gl(glBufferData(GL_DRAW_INDIRECT_BUFFER, m_capacity * sizeof(draw_indirect_command), nullptr, GL_STREAM_DRAW));
+        gl(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size_bytes(), commands.data()));
+    }
+
+    storage_buffer::storage_buffer(uint32_t s, uint32_t binding) : m_size(s), m_binding(binding){
+        gl(glGenBuffers(1, &m_id));
+        state_cache::buffer(GL_SHADER_STORAGE_BUFFER, m_id);
+        gl(glBufferData(GL_SHADER_STORAGE_BUFFER, m_size, nullptr, GL_STREAM_DRAW));
+    }
+
+    storage_buffer::~storage_buffer(){
+        state_cache::forget_buffer(m_id);
+        gl(glDeleteBuffers(1, &m_id));
+    }
+
+    void storage_buffer::bind() const{
+        state_cache::buffer_base(GL_SHADER_STORAGE_BUFFER, m_binding, m_id);
+    }
+
+    void storage_buffer::set_data(const void* data, uint32_t size){
+        if(size > m_size) m_size = std::max(size, m_size * 2);
+
+        state_cache::buffer(GL_SHADER_STORAGE_BUFFER, m_id);
+        gl(glBufferData(GL_SHADER_STORAGE_BUFFER, m_size, nullptr, GL_STREAM_DRAW));
+        gl(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data));
     }
 
+    // Indexed by gapi::ATTRIBUTE.
+    static constexpr DATA_TYPE s_attribute_types[] = {
+        FLOAT, HALF_FLOAT, BYTE, UBYTE, SHORT, USHORT, INT, UINT, INT_2_10_10_10, UINT_2_10_10_10
+    };
+
     vertex_array::vertex_array(){
         gl(glGenVertexArrays(1, &m_id));
     }
 
     vertex_array::~vertex_array(){
+        state_cache::forget_vertex_array(m_id);
         gl(glDeleteVertexArrays(1, &m_id));
     }
 
     void vertex_array::bind() const {
-        gl(glBindVertexArray(m_id));
+        state_cache::vertex_array(m_id);
     }
 
     void vertex_array::unbind() const {
-        gl(glBindVertexArray(0));
+        state_cache::vertex_array(0);
     }
 
     void vertex_array::emplace_vertex(const std::shared_ptr<gapi::vertex_buffer>& vb){
         vb->bind();
         const auto& layout = vb->layout();
         const auto& elements = layout.elements();
-        size_t index = 0;
+        // Locations continue across buffers so per-instance data can follow the mesh attributes.
         for(const auto& element : elements)
         {
-            gl(glEnableVertexAttribArray(index));
-            gl(glVertexAttribPointer(index, element.component, FLOAT, 
-                element.normalized, layout.stride(), (const void*)(element.offset)));
-            index++;
+            const DATA_TYPE type = s_attribute_types[element.type];
+            for(uint32_t i = 0; i < element.locations(); i++)
+            {
+                const void* offset = (const void*)(uintptr_t)(element.offset + i * element.column_size());
+                gl(glEnableVertexAttribArray(m_attribute_index));
+                if(element.integer()){
+                    gl(glVertexAttribIPointer(m_attribute_index, element.component, type, layout.stride(), offset));
+                }
+                else{
+                    gl(glVertexAttribPointer(m_attribute_index, element.component, type, element.normalized, layout.stride(), offset));
+                }
+                gl(glVertexAttribDivisor(m_attribute_index, element.step == STEP_INSTANCE ? 1 : 0));
+                m_attribute_index++;
+            }
         }
         m_vertex_buffers.emplace_back(vb);
     }
@@ -179,23 +652,175 @@ namespace gapi::opengl{
         m_index_buffer = ib;
     }
 
-    uint32_t shader::validator(const std::string& n) const {
-        uint32_t uniform_location = gl(glGetUniformLocation(m_id, n.c_str()));
-        if(uniform_location == -1) {
-            gapi_debug_msg("Uniform not found: ", n);
-            return -1;
+    void shader::reflect() const {
+        m_uniforms.clear();
+
+        int32_t count{0}, max_length{0};
+        gl(glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count));
+        gl(glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length));
+        if(count <= 0) return;
+
+        std::vector<char> name(max_length + 1);
+        m_uniforms.reserve(count);
+        for(int32_t i = 0; i < count; i++){
+            int32_t length{0}, size{0};
+            GLenum type{GL_NONE};
+            gl(glGetActiveUniform(m_id, i, max_length, &length, &size, &type, name.data()));
+            int32_t location = gl(glGetUniformLocation(m_id, name.data()));
+            if(location < 0) continue; // members of uniform blocks have no location
+
+            std::string_view uniform_name(name.data(), length);
+            m_uniforms.push_back({uniform_hash::fnv1a(uniform_name), location, type, size});
+
+            // Arrays are reported as "name[0]", make them reachable by their plain name as well.
+            size_t bracket = uniform_name.find('[');
+            if(bracket != std::string_view::npos)
+                m_uniforms.push_back({uniform_hash::fnv1a(uniform_name.substr(0, bracket)), location, type, size});
+        }
+
+        std::sort(m_uniforms.begin(), m_uniforms.end(), [](const uniform_info& a, const uniform_info& b){ return a.hash < b.hash; });
+
+        // Lookups only see the hash, two names sharing one would silently alias each other
+        gapi_asserts(std::adjacent_find(m_uniforms.begin(), m_uniforms.end(), [](const uniform_info& a, const uniform_info& b){ return a.hash == b.hash; }) == m_uniforms.end(),
+            "Two uniform names of " + m_name + " share a hash, rename one of them");
+
+        int32_t blocks{0}, max_block_length{0};
+        gl(glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_BLOCKS, &blocks));
+        gl(glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_block_length));
+
+        std::vector<char> block_name(max_block_length + 1);
+        for(int32_t i = 0; i < blocks; i++){
+            int32_t length{0};
+            gl(glGetActiveUniformBlockName(m_id, i, max_block_length, &length, block_name.data()));
+            uint32_t binding = uniform_bindings::binding(std::string_view(block_name.data(), length));
+            if(binding == UNIFORM_BINDING_NONE){
+                gapi_debug_msg("Uniform block has no binding point: ", block_name.data());
+                continue;
+            }
+            gl(glUniformBlockBinding(m_id, i, binding));
+        }
+    }
+
+    void program_cache::configure(const std::filesystem::path& directory, const gapi::info& info){
+        int32_t formats{0};
+        gl(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        s_enabled = formats > 0 && !error;
+        if(!s_enabled){
+            gapi_debug_msg("Program binary cache disabled: ", directory.string());
+            return;
         }
 
-        return uniform_location;
+        s_directory = directory;
+        s_device = fnv1a64(fnv1a64_basis, info.vendor());
+        s_device = fnv1a64(s_device, info.renderer());
+        s_device = fnv1a64(s_device, info.version());
     }
 
-    void shader::compile(std::unordered_map<SHADER_TYPE, std::string> sources){
-        uint32_t shader_program = gl(glCreateProgram());
-        if(shader_program == GL_FALSE) return;
+    uint64_t program_cache::key(const std::unordered_map<SHADER_TYPE, std::string>& sources){
+        std::vector<std::pair<SHADER_TYPE, std::string_view>> stages(sources.begin(), sources.end());
+        std::sort(stages.begin(), stages.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+
+        uint64_t hash = s_device;
+        for(const auto& [type, source] : stages){
+            hash = fnv1a64(hash, std::string_view(reinterpret_cast<const char*>(&type), sizeof(type)));
+            hash = fnv1a64(hash, source);
+        }
+        return hash;
+    }
+
+    std::filesystem::path program_cache::path(uint64_t key){
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return s_directory / name.str();
+    }
+
+    bool program_cache::load(uint32_t program, uint64_t key){
+        std::ifstream file(path(key), std::ios::in | std::ios::binary);
+        if(!file){
+            s_stats.misses++;
+            return false;
+        }
+
+        GLenum format{GL_NONE};
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+
+        int32_t linked{GL_FALSE};
+        if(!binary.empty()){
+            // Not wrapped in gl(): a binary from another driver build is expected to fail here.
+            glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+            while(glGetError() != GL_NO_ERROR);
+            gl(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+        }
+
+        if(linked == GL_FALSE){
+            std::error_code error;
+            std::filesystem::remove(path(key), error);
+            s_stats.rejected++;
+            return false;
+        }
+
+        s_stats.hits++;
+        return true;
+    }
+
+    void program_cache::store(uint32_t program, uint64_t key){
+        int32_t length{0};
+        gl(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+        if(length <= 0) return;
+
+        GLenum format{GL_NONE};
+        std::vector<char> binary(length);
+        gl(glGetProgramBinary(program, length, nullptr, &format, binary.data()));
+
+        // Written under a temporary name so a crash never leaves a truncated binary behind.
+        const std::filesystem::path target = path(key);
+        std::filesystem::path staging = target;
+        staging += ".tmp";
+        {
+            std::ofstream file(staging, std::ios::out | std::ios::binary | std::ios::trunc);
+            if(!file){
+                gapi_debug_msg("Failed to write program binary: ", staging.string());
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            file.write(binary.data(), binary.size());
+        }
+
+        std::error_code error;
+        std::filesystem::rename(staging, target, error);
+        if(error) std::filesystem::remove(staging, error);
+    }
+
+    // Only issues the work: compile and link run on the driver's threads until resolve()
+    // asks for their status, which happens on first use or when ready() sees completion.
+    void shader::compile(stage_sources sources){
+        m_cache_key = program_cache::enabled() ? program_cache::key(sources) : 0;
+        m_id = link(sources, m_cache_key, m_stages);
+        if(m_id == 0) return;
+        if(m_stages.empty()) reflect();
+        else m_pending = true;
+    }
+
+    // Returns a program that is linked, or still linking when stages is non-empty. A program
+    // restored from the binary cache has no stages and is complete on return.
+    uint32_t shader::link(const stage_sources& sources, uint64_t key, std::vector<uint32_t>& stages) const {
+        const bool cached = key != 0;
+        if(cached){
+            uint32_t program = gl(glCreateProgram());
+            if(program_cache::load(program, key)) return program;
+            gl(glDeleteProgram(program));
+        }
 
-        std::vector<uint32_t> shaders;
-        shaders.reserve(sources.size());
+        uint32_t shader_program = gl(glCreateProgram());
+        if(shader_program == GL_FALSE) return 0;
+        if(cached) gl(glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
 
+        stages.reserve(sources.size());
         for(auto& source : sources){
             SHADER_TYPE type = source.first;
             const std::string& src = source.second;
@@ -205,7 +830,16 @@ namespace gapi::opengl{
 
             gl(glShaderSource(shader_id, 1, &src_cstr, nullptr));
             gl(glCompileShader(shader_id));
+            gl(glAttachShader(shader_program, shader_id));
+            stages.push_back(shader_id);
+        }
 
+        gl(glLinkProgram(shader_program));
+        return shader_program;
+    }
+
+    bool shader::linked(uint32_t program, const std::vector<uint32_t>& stages) const {
+        for(auto shader_id : stages){
             int32_t result{0};
             gl(glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result));
 
@@ -216,40 +850,191 @@ namespace gapi::opengl{
                 gl(glGetShaderInfoLog(shader_id, message_length, &message_length, &compile_error_message[0]));
                 gapi_debug_msg("Shader compilation error: ", compile_error_message.data());
             }
-
-            gl(glAttachShader(shader_program, shader_id));
-            shaders.push_back(shader_id);
         }
 
         int result{0};
-        gl(glLinkProgram(shader_program));
-        gl(glGetProgramiv(shader_program, GL_LINK_STATUS, &result));
+        gl(glGetProgramiv(program, GL_LINK_STATUS, &result));
 
         if(result == GL_FALSE){
             int message_length = 0;
-            gl(glGetProgramiv(shader_program, GL_INFO_LOG_LENGTH, &message_length));
+            gl(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &message_length));
             std::vector<char> link_error_message(message_length);
-            gl(glGetProgramInfoLog(shader_program, message_length, &message_length, &link_error_message[0]));
+            gl(glGetProgramInfoLog(program, message_length, &message_length, &link_error_message[0]));
             gapi_debug_msg("Shader linking error: ", link_error_message.data());
+            return false;
         }
 
-        gl(glValidateProgram(shader_program));
-        gl(glGetProgramiv(shader_program, GL_VALIDATE_STATUS, &result));
+#ifdef _DEBUG
+        gl(glValidateProgram(program));
+        gl(glGetProgramiv(program, GL_VALIDATE_STATUS, &result));
 
         if(result == GL_FALSE){
             int message_length = 0;
-            gl(glGetProgramiv(shader_program, GL_INFO_LOG_LENGTH, &message_length));
+            gl(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &message_length));
             std::vector<char> validate_error_message(message_length);
-            gl(glGetProgramInfoLog(shader_program, message_length, &message_length, &validate_error_message[0]));
+            gl(glGetProgramInfoLog(program, message_length, &message_length, &validate_error_message[0]));
             gapi_debug_msg("Shader validation error: ", validate_error_message.data());
         }
+#endif
+        return true;
+    }
 
-        for(auto& shader : shaders){
-            gl(glDetachShader(shader_program, shader));
+    void shader::release(uint32_t program, std::vector<uint32_t>& stages) const {
+        for(auto& shader : stages){
+            gl(glDetachShader(program, shader));
             gl(glDeleteShader(shader));
         }
+        stages.clear();
+    }
+
+    bool shader::ready() const {
+        if(!m_pending) return true;
+        if(s_parallel_compile){
+            int32_t done{GL_FALSE};
+            gl(glGetProgramiv(m_id, GL_COMPLETION_STATUS_KHR, &done));
+            if(done == GL_FALSE) return false;
+        }
+        resolve();
+        return true;
+    }
+
+    void shader::resolve() const {
+        if(!m_pending) return;
+        m_pending = false;
+
+        if(linked(m_id, m_stages) && program_cache::enabled())
+            program_cache::store(m_id, m_cache_key);
+        release(m_id, m_stages);
+        reflect();
+    }
+
+    // Reads and preprocesses every stage, recording each file it touched so edits to an
+    // include trigger a reload too. Touches no GL state and is safe on a worker thread.
+    shader::stage_sources shader::build(std::vector<std::filesystem::path>& files) const {
+        for(const auto& path : m_paths){
+            if(!std::filesystem::exists(path)){
+                gapi_debug_msg("Shader parse error: ", "Shader file does not exist");
+                return {};
+            }
+            std::error_code error;
+            files.push_back(std::filesystem::weakly_canonical(path, error));
+        }
+
+        if(m_paths.size() == 1){
+            auto shader_sources = pre_process(read_file(m_paths[0]));
+            for(auto& [type, stage] : shader_sources)
+                stage = expand(stage, m_paths[0].parent_path(), m_defines, files);
+            return shader_sources;
+        }
+
+        return {
+            {SHADER_VERTEX, expand(read_file(m_paths[0]), m_paths[0].parent_path(), m_defines, files)},
+            {SHADER_FRAGMENT, expand(read_file(m_paths[1]), m_paths[1].parent_path(), m_defines, files)}
+        };
+    }
+
+    void shader::reload(){
+        if(m_rebuild.valid()){
+            m_stale = true;
+            return;
+        }
+        m_rebuild = std::async(std::launch::async, [this]{
+            rebuild result{};
+            result.sources = build(result.files);
+            return result;
+        });
+    }
+
+    // Frame boundary step of a reload: submits the rebuilt sources once the worker is done,
+    // then installs the program once the driver has linked it. Neither step waits.
+    bool shader::swap(){
+        if(m_rebuild.valid() && m_rebuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+            rebuild result = m_rebuild.get();
+            if(m_stale){
+                m_stale = false;
+                reload();
+            }
+            else if(!result.sources.empty()){
+                if(m_next != 0){
+                    release(m_next, m_next_stages);
+                    gl(glDeleteProgram(m_next));
+                }
+                m_next_key = program_cache::enabled() ? program_cache::key(result.sources) : 0;
+                m_next = link(result.sources, m_next_key, m_next_stages);
+                m_next_files = std::move(result.files);
+            }
+        }
+
+        if(m_next == 0) return false;
+        if(s_parallel_compile && !m_next_stages.empty()){
+            int32_t done{GL_FALSE};
+            gl(glGetProgramiv(m_next, GL_COMPLETION_STATUS_KHR, &done));
+            if(done == GL_FALSE) return false;
+        }
+
+        const uint32_t next = std::exchange(m_next, 0);
+        const bool from_cache = m_next_stages.empty();
+        const bool ok = linked(next, m_next_stages);
+        release(next, m_next_stages);
+        if(!ok){
+            gl(glDeleteProgram(next));
+            gapi_debug_msg("Shader reload failed, keeping the previous program: ", m_name);
+            return false;
+        }
+        if(!from_cache && program_cache::enabled()) program_cache::store(next, m_next_key);
+
+        resolve();
+        std::vector<uniform_info> previous = std::move(m_uniforms);
+        const uint32_t program = std::exchange(m_id, next);
+        m_cache_key = m_next_key;
+        m_files = std::move(m_next_files);
+        reflect();
+        m_generation++;
+        carry(program, previous);
+        gl(glDeleteProgram(program));
+        gapi_debug_msg("Shader reloaded: ", m_name);
+        return true;
+    }
 
-        m_id = shader_program;
+    // Copies the values of uniforms that kept their name and type from the replaced program,
+    // so state set once at load time (samplers, constants) survives a reload.
+    void shader::carry(uint32_t program, const std::vector<uniform_info>& previous) const {
+        for(const auto& uniform : m_uniforms){
+            auto it = std::lower_bound(previous.begin(), previous.end(), uniform.hash, [](const uniform_info& u, uint32_t hash){ return u.hash < hash; });
+            if(it == previous.end() || it->hash != uniform.hash || it->type != uniform.type) continue;
+
+            const int32_t count = std::min(uniform.size, it->size);
+            for(int32_t i = 0; i < count; i++){
+                const int32_t from = it->location + i, to = uniform.location + i;
+                float f[16]{};
+                int32_t n[4]{};
+                uint32_t u[4]{};
+                switch(uniform.type){
+                    case GL_FLOAT:              gl(glGetUniformfv(program, from, f)); gl(glProgramUniform1fv(m_id, to, 1, f)); break;
+                    case GL_FLOAT_VEC2:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniform2fv(m_id, to, 1, f)); break;
+                    case GL_FLOAT_VEC3:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniform3fv(m_id, to, 1, f)); break;
+                    case GL_FLOAT_VEC4:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniform4fv(m_id, to, 1, f)); break;
+                    case GL_FLOAT_MAT2:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniformMatrix2fv(m_id, to, 1, GL_FALSE, f)); break;
+                    case GL_FLOAT_MAT3:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniformMatrix3fv(m_id, to, 1, GL_FALSE, f)); break;
+                    case GL_FLOAT_MAT4:         gl(glGetUniformfv(program, from, f)); gl(glProgramUniformMatrix4fv(m_id, to, 1, GL_FALSE, f)); break;
+                    case GL_INT_VEC2:           gl(glGetUniformiv(program, from, n)); gl(glProgramUniform2iv(m_id, to, 1, n)); break;
+                    case GL_INT_VEC3:           gl(glGetUniformiv(program, from, n)); gl(glProgramUniform3iv(m_id, to, 1, n)); break;
+                    case GL_INT_VEC4:           gl(glGetUniformiv(program, from, n)); gl(glProgramUniform4iv(m_id, to, 1, n)); break;
+                    case GL_UNSIGNED_INT:       gl(glGetUniformuiv(program, from, u)); gl(glProgramUniform1uiv(m_id, to, 1, u)); break;
+                    case GL_INT:
+                    case GL_BOOL:
+                    case GL_SAMPLER_2D:
+                    case GL_SAMPLER_2D_ARRAY:
+                    case GL_SAMPLER_CUBE:
+                    case GL_SAMPLER_3D:
+                    case GL_SAMPLER_2D_SHADOW:
+                    case GL_INT_SAMPLER_2D:
+                    case GL_UNSIGNED_INT_SAMPLER_2D:
+                                                gl(glGetUniformiv(program, from, n)); gl(glProgramUniform1iv(m_id, to, 1, n)); break;
+                    default: break;
+                }
+            }
+        }
     }
 
     std::string shader::read_file(const std::filesystem::path& file_path) const{
@@ -276,18 +1061,17 @@ namespace gapi::opengl{
         return SHADER_TYPE::SHADER_NONE;
     }
 
-    std::unordered_map<SHADER_TYPE, std::string> shader::pre_process(const std::string& src) const {
+    shader::stage_sources shader::pre_process(const std::string& src) const {
         std::unordered_map<SHADER_TYPE,std::string> shader_sources;
-        const char *type_token = "#type";
-        size_t type_token_length = strlen(type_token);
+        constexpr std::string_view type_token = "#type";
         size_t pos = src.find(type_token, 0);
 
         while(pos != std::string::npos){
             size_t eol = src.find_first_of("\r\n", pos);
-            gapi_asserts(eol == std::string::npos, "Syntax error, Did you forget to add shader type line #type declaration");
-            size_t begin = pos + type_token_length + 1;
+            gapi_asserts(eol != std::string::npos, "Syntax error, Did you forget to add shader type line #type declaration");
+            size_t begin = pos + type_token.size() + 1;
             std::string type = src.substr(begin, eol - begin);
-            gapi_asserts(type != "vertex" && type != "fragment" && type != "pixel" && type != "geometry", "Invalid shader type specified");
+            gapi_asserts(type == "vertex" || type == "fragment" || type == "pixel" || type == "geometry", "Invalid shader type specified");
             size_t next_line_pos = src.find_first_not_of("\r\n", eol);
             pos = src.find(type_token, next_line_pos);
             shader_sources[shader_type_from_string(type)] = src.substr(next_line_pos, pos - (next_line_pos == std::string::npos ? src.size() - 1 : next_line_pos));
@@ -296,171 +1080,1209 @@ namespace gapi::opengl{
         return shader_sources;
     }
 
-    shader::shader(const std::string& sname, const std::filesystem::path& path){
-        if(!std::filesystem::exists(path)){
-            gapi_debug_msg("Shader parse error: ", "Shader file does not exist");
-            return;
-        }
-
-        std::string source = read_file(path);
-        auto shader_sources = pre_process(source);
-        compile(shader_sources);
-        m_name = sname;
+    // Resolves includes for one stage and injects the defines right after its #version line.
+    std::string shader::expand(const std::string& src, const std::filesystem::path& directory, const shader_defines& defines, std::vector<std::filesystem::path>& files) const {
+        std::vector<std::filesystem::path> included;
+        std::string result = include(src, directory, included);
+        for(auto& path : included)
+            if(std::find(files.begin(), files.end(), path) == files.end()) files.push_back(std::move(path));
+        if(defines.empty()) return result;
+
+        size_t version = result.find("#version");
+        size_t eol = version == std::string::npos ? std::string::npos : result.find('\n', version);
+        if(eol == std::string::npos) return defines.source() + result;
+        return result.insert(eol + 1, defines.source());
     }
 
-    shader::shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment){
-        if(!std::filesystem::exists(vertex) || !std::filesystem::exists(fragment)){
-            gapi_debug_msg("Shader parse error: ", "Shader file does not exist");
-            return;
-        }
+    // #include "file" is relative to the including file; a file is pasted at most once per stage.
+    std::string shader::include(const std::string& src, const std::filesystem::path& directory, std::vector<std::filesystem::path>& included) const {
+        constexpr std::string_view include_token = "#include";
+        std::string result;
+        result.reserve(src.size());
+
+        std::istringstream lines(src);
+        for(std::string line; std::getline(lines, line);){
+            size_t first = line.find_first_not_of(" \t");
+            if(first == std::string::npos || line.compare(first, include_token.size(), include_token) != 0){
+                result += line;
+                result += '\n';
+                continue;
+            }
 
-        std::string vertex_source = read_file(vertex);
-        std::string fragment_source = read_file(fragment);
-        std::unordered_map<SHADER_TYPE, std::string> shader_sources = {
-            {SHADER_VERTEX, vertex_source},
-            {SHADER_FRAGMENT, fragment_source}
-        };
+            size_t open = line.find('"', first + include_token.size());
+            size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+            if(close == std::string::npos){
+                gapi_debug_msg("Shader include syntax error: ", line);
+                continue;
+            }
+
+            std::error_code error;
+            std::filesystem::path path = std::filesystem::weakly_canonical(directory / line.substr(open + 1, close - open - 1), error);
+            if(std::find(included.begin(), included.end(), path) != included.end()) continue;
+            included.push_back(path);
+
+            result += include(read_file(path), path.parent_path(), included);
+        }
+
+        return result;
+    }
+
+    shader::shader(const std::string& sname, const std::filesystem::path& path, const shader_defines& defines)
+        : m_name(sname), m_paths{path}, m_defines(defines){
+        auto shader_sources = build(m_files);
+        if(shader_sources.empty()) return;
+        compile(shader_sources);
+    }
+
+    shader::shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment, const shader_defines& defines)
+        : m_name(sname), m_paths{vertex, fragment}, m_defines(defines){
+        auto shader_sources = build(m_files);
+        if(shader_sources.empty()) return;
         compile(shader_sources);
-        m_name = sname;
     }
 
     shader::~shader(){
+        if(m_rebuild.valid()) m_rebuild.wait();
+        if(m_next != 0){
+            release(m_next, m_next_stages);
+            gl(glDeleteProgram(m_next));
+        }
         gl(glDeleteProgram(m_id));
     }
 
     void shader::bind() const {
-        gl(glUseProgram(m_id));
+        if(m_pending) resolve();
+        state_cache::program(m_id);
     }
 
     void shader::unbind() const {
-        gl(glUseProgram(0));
+        state_cache::program(0);
     }
 
-    bool shader::uniform(const std::string& n, uint32_t v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform1i(uniform_location, v));
+    uniform_handle shader::handle(std::string_view n) const {
+        uniform_handle h = handle(uniform_hash(n));
+        if(!h.valid()) {
+            gapi_debug_msg("Uniform not found: ", n);
+        }
+        return h;
+    }
+
+    uniform_handle shader::handle(uniform_hash h) const {
+        if(m_pending) resolve();
+        auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), h.value, [](const uniform_info& u, uint32_t hash){ return u.hash < hash; });
+        if(it == m_uniforms.end() || it->hash != h.value) return {};
+        return {it->location, h.value, m_generation};
+    }
+
+    int32_t shader::location(uniform_handle h) const {
+        if(!h.valid() || h.generation == m_generation) return h.location;
+        uniform_hash name{};
+        name.value = h.hash;
+        return handle(name).location;
+    }
+
+    bool shader::uniform(uniform_handle h, uint32_t v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform1i(location, v));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, float v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform1f(uniform_location, v));
+    bool shader::uniform(uniform_handle h, float v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform1f(location, v));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, float x, float y) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform2f(uniform_location, x, y));
+    bool shader::uniform(uniform_handle h, float x, float y) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform2f(location, x, y));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, float x, float y, float z) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform3f(uniform_location, x, y, z));
+    bool shader::uniform(uniform_handle h, float x, float y, float z) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform3f(location, x, y, z));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, float x, float y, float z, float w) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform4f(uniform_location, x, y, z, w));
+    bool shader::uniform(uniform_handle h, float x, float y, float z, float w) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform4f(location, x, y, z, w));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::vec2& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform2fv(uniform_location, 1, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::vec2& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform2fv(location, 1, glm::value_ptr(v)));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::vec3& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform3fv(uniform_location, 1, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::vec3& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform3fv(location, 1, glm::value_ptr(v)));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::vec4& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniform4fv(uniform_location, 1, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::vec4& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform4fv(location, 1, glm::value_ptr(v)));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::mat2& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniformMatrix2fv(uniform_location, 1, GL_FALSE, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::mat2& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(v)));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::mat3& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniformMatrix3fv(uniform_location, 1, GL_FALSE, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::mat3& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(v)));
         return true;
     }
 
-    bool shader::uniform(const std::string& n, const glm::mat4& v) const {
-        uint32_t uniform_location = validator(n);
-        if(uniform_location == -1) return false;
-        gl(glUniformMatrix4fv(uniform_location, 1, GL_FALSE, glm::value_ptr(v)));
+    bool shader::uniform(uniform_handle h, const glm::mat4& v) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(v)));
         return true;
     }
 
-    texture_2d::texture_2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip){
-        m_path = path.string();
-        stbi_set_flip_vertically_on_load(flip);
-        m_data = stbi_load(m_path.c_str(), &m_width, &m_height, &m_channels, 0);
-        gapi_asserts(m_data == nullptr, "Failed to load texture data");
+    bool shader::uniform(uniform_handle h, const int32_t* v, uint32_t count) const {
+        const int32_t location = this->location(h);
+        if(location < 0) return false;
+        gl(glUniform1iv(location, count, v));
+        return true;
+    }
 
-        GLenum internal_format = 0, data_format = 0;
-        if(m_channels == 4){
-            internal_format = GL_RGBA8;
-            data_format = GL_RGBA;
+    static bool texture_formats(int32_t channels, GLenum& internal_format, GLenum& data_format){
+        switch(channels){
+            case 1: internal_format = GL_R8;    data_format = GL_RED;  return true;
+            case 2: internal_format = GL_RG8;   data_format = GL_RG;   return true;
+            case 3: internal_format = GL_RGB8;  data_format = GL_RGB;  return true;
+            case 4: internal_format = GL_RGBA8; data_format = GL_RGBA; return true;
+            default: return false;
         }
-        else if(m_channels == 3){
-            internal_format = GL_RGB8;
-            data_format = GL_RGB;
+    }
+
+    static bool texture_mipmapped(TEXTURE_FILTER filter){
+        return filter == TEX_FILTER_NEAREST_MIPMAP || filter == TEX_FILTER_LINEAR_MIPMAP;
+    }
+
+    // Full chain for mipmapped filters, immutable storage then clamps sampling to what exists.
+    static int32_t texture_levels(TEXTURE_FILTER filter, int32_t width, int32_t height){
+        if(!texture_mipmapped(filter)) return 1;
+        return 1 + static_cast<int32_t>(std::floor(std::log2(static_cast<float>(std::max({width, height, 1})))));
+    }
+
+    static GLenum block_internal_format(BLOCK_FORMAT format, bool srgb){
+        switch(format){
+            case BLOCK_BC1:  return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BLOCK_BC1A: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case BLOCK_BC2:  return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT : GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            case BLOCK_BC3:  return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BLOCK_BC4:  return GL_COMPRESSED_RED_RGTC1;
+            case BLOCK_BC5:  return GL_COMPRESSED_RG_RGTC2;
+            case BLOCK_BC7:  return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM    : GL_COMPRESSED_RGBA_BPTC_UNORM;
+            default:         return GL_NONE;
         }
+    }
 
-        gapi_asserts(internal_format == 0 || data_format == 0, "Texture format not supported");
+    // S3TC was never promoted to core; RGTC is core since 3.0 and BPTC since 4.2.
+    static bool block_format_supported(BLOCK_FORMAT format, bool srgb){
+        switch(format){
+            case BLOCK_BC1: case BLOCK_BC1A: case BLOCK_BC2: case BLOCK_BC3:
+                return GLEW_EXT_texture_compression_s3tc && (!srgb || GLEW_EXT_texture_sRGB);
+            case BLOCK_BC4: case BLOCK_BC5:
+                return true;
+            case BLOCK_BC7:
+                return GLEW_ARB_texture_compression_bptc;
+            default:
+                return false;
+        }
+    }
+
+    static void texture_parameters(TEXTURE_FILTER filter, TEXTURE_WRAP wrap, TEXTURE_TYPE target = TEXTURE_2D){
+        gl(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter));
+        gl(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, texture_mipmapped(filter) ? GL_LINEAR : filter));
+        gl(glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap));
+        gl(glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap));
+    }
+
+    texture_2d::texture_2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip, bool keep_data)
+        : m_path(path.string()), m_filter(filter), m_wrap(wrap), m_flip(flip), m_keep_data(keep_data){
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(TEXTURE_2D, m_id);
+        texture_parameters(filter, wrap);
+        load(flip);
+    }
+
+    texture_2d::texture_2d(int32_t width, int32_t height, int32_t channels, const uint8_t* pixels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap)
+        : m_width(width), m_height(height), m_channels(channels), m_filter(filter), m_wrap(wrap){
+        GLenum internal_format = 0, data_format = 0;
+        bool supported = texture_formats(m_channels, internal_format, data_format);
+        gapi_asserts(supported, "Texture format not supported");
 
         gl(glGenTextures(1, &m_id));
-        gl(glBindTexture(TEXTURE_2D, m_id));
-        gl(glTexParameteri(TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter));
-        gl(glTexParameteri(TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter));
-        gl(glTexParameteri(TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap));
-        gl(glTexParameteri(TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap));
-        gl(glTexImage2D(TEXTURE_2D, 0, internal_format, m_width, m_height, 0, data_format, GL_UNSIGNED_BYTE, m_data));
+        state_cache::texture(TEXTURE_2D, m_id);
+        texture_parameters(filter, wrap);
+        storage(internal_format);
+        if(pixels == nullptr) return;
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        gl(glTexSubImage2D(TEXTURE_2D, 0, 0, 0, m_width, m_height, data_format, GL_UNSIGNED_BYTE, pixels));
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        if(m_levels > 1) gl(glGenerateMipmap(TEXTURE_2D));
+    }
+
+    texture_2d::texture_2d(TEXTURE_FILTER filter, TEXTURE_WRAP wrap, std::shared_ptr<const texture_2d> placeholder)
+        : m_filter(filter), m_wrap(wrap), m_placeholder(std::move(placeholder)){
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(TEXTURE_2D, m_id);
+        texture_parameters(filter, wrap);
     }
 
     texture_2d::~texture_2d(){
+        state_cache::forget_texture(m_id);
         gl(glDeleteTextures(1, &m_id));
         stbi_image_free(m_data);
     }
 
     void texture_2d::bind(uint32_t slot) const {
-        gl(glActiveTexture(GL_TEXTURE0 + slot));
-        gl(glBindTexture(GL_TEXTURE_2D, m_id));
+        m_last_bind = ++s_bind_clock;
+        if(m_placeholder){
+            m_placeholder->bind(slot);
+            return;
+        }
+        state_cache::texture(slot, GL_TEXTURE_2D, m_id);
     }
 
     void texture_2d::unbind() const {
-        gl(glBindTexture(GL_TEXTURE_2D, 0));
+        state_cache::texture(GL_TEXTURE_2D, 0);
+    }
+
+    void texture_2d::set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels){
+        GLenum internal_format = 0, data_format = 0;
+        if(!texture_formats(m_channels, internal_format, data_format)){
+            gapi_debug_msg("Texture has no storage yet: ", m_path);
+            return;
+        }
+        if(m_compressed){
+            gapi_debug_msg("Block compressed textures can't be updated with pixels: ", m_path);
+            return;
+        }
+        gapi_asserts(x + width <= m_width && y + height <= m_height, "Texture data exceeds texture size");
+
+        state_cache::texture(TEXTURE_2D, m_id);
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        gl(glTexSubImage2D(TEXTURE_2D, 0, x, y, width, height, data_format, GL_UNSIGNED_BYTE, pixels));
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        if(m_levels > 1) gl(glGenerateMipmap(TEXTURE_2D));
+    }
+
+    void texture_2d::release_data(){
+        stbi_image_free(m_data);
+        m_data = nullptr;
+    }
+
+    // Fills the texture, which already has its name and parameters, from m_path.
+    void texture_2d::load(bool flip){
+        state_cache::texture(TEXTURE_2D, m_id);
+        if(compressed_container(m_path)){
+            compressed_image image{};
+            if(load_compressed(m_path, image)) upload(image);
+            return;
+        }
+
+        stbi_set_flip_vertically_on_load(flip);
+        m_data = stbi_load(m_path.c_str(), &m_width, &m_height, &m_channels, 0);
+        gapi_asserts(m_data != nullptr, "Failed to load texture data");
+
+        GLenum internal_format = 0, data_format = 0;
+        bool supported = texture_formats(m_channels, internal_format, data_format);
+        gapi_asserts(supported, "Texture format not supported");
+
+        storage(internal_format);
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        gl(glTexSubImage2D(TEXTURE_2D, 0, 0, 0, m_width, m_height, data_format, GL_UNSIGNED_BYTE, m_data));
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        if(m_levels > 1) gl(glGenerateMipmap(TEXTURE_2D));
+        if(!m_keep_data) release_data();
+    }
+
+    // Immutable storage can't be reallocated, so the storage goes with the name and a fresh
+    // name without storage takes its place until load() or the loader fills it again.
+    void texture_2d::evict(std::shared_ptr<const texture_2d> placeholder){
+        state_cache::forget_texture(m_id);
+        gl(glDeleteTextures(1, &m_id));
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(TEXTURE_2D, m_id);
+        texture_parameters(m_filter, m_wrap);
+        release_data();
+        m_memory = 0;
+        m_levels = 1;
+        m_compressed = false;
+        m_storage = false;
+        m_placeholder = std::move(placeholder);
+    }
+
+    // Immutable storage for the current size; the texture must be bound.
+    void texture_2d::storage(GLenum internal_format){
+        m_levels = texture_levels(m_filter, m_width, m_height);
+        gl(glTexStorage2D(TEXTURE_2D, m_levels, internal_format, m_width, m_height));
+        m_storage = true;
+
+        m_memory = 0;
+        for(int32_t level = 0; level < m_levels; level++)
+            m_memory += static_cast<uint64_t>(std::max(1, m_width >> level)) * std::max(1, m_height >> level) * m_channels;
+    }
+
+    // Uploads block compressed levels as they are when the driver knows the format, otherwise
+    // decodes them to RGBA8 first. Mip levels come from the file; a mipmapped filter on a file
+    // without them generates the chain, which only works on the decoded path. Returns false when
+    // the format can't be decoded either, the storage is allocated but undefined then.
+    bool texture_2d::upload(const compressed_image& image){
+        state_cache::texture(TEXTURE_2D, m_id);
+        m_width = image.width;
+        m_height = image.height;
+
+        const bool mipmapped = texture_mipmapped(m_filter);
+        const int32_t file_levels = mipmapped ? static_cast<int32_t>(image.levels.size()) : 1;
+        const GLenum internal_format = block_internal_format(image.format, image.srgb);
+        if(internal_format != GL_NONE && block_format_supported(image.format, image.srgb)){
+            m_channels = block_channels(image.format);
+            m_levels = file_levels;
+            m_compressed = true;
+            m_memory = 0;
+            gl(glTexStorage2D(TEXTURE_2D, m_levels, internal_format, m_width, m_height));
+            m_storage = true;
+            for(int32_t level = 0; level < m_levels; level++){
+                const auto& l = image.levels[level];
+                gl(glCompressedTexSubImage2D(TEXTURE_2D, level, 0, 0, l.width, l.height, internal_format, static_cast<GLsizei>(l.size), image.blocks(level)));
+                m_memory += l.size;
+            }
+            return true;
+        }
+
+        gapi_debug_msg("Compressed format not supported by the driver, decoding on the CPU: ", m_path);
+        m_channels = 4;
+        m_levels = file_levels > 1 ? file_levels : texture_levels(m_filter, m_width, m_height);
+        gl(glTexStorage2D(TEXTURE_2D, m_levels, image.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, m_width, m_height));
+        m_storage = true;
+
+        std::vector<uint8_t> rgba;
+        m_memory = 0;
+        for(int32_t level = 0; level < file_levels; level++){
+            const auto& l = image.levels[level];
+            if(!decode_blocks(image.format, image.blocks(level), l.width, l.height, rgba)){
+                gapi_debug_msg("No CPU decoder for this compressed format: ", m_path);
+                return false;
+            }
+            gl(glTexSubImage2D(TEXTURE_2D, level, 0, 0, l.width, l.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data()));
+        }
+        if(m_levels > file_levels) gl(glGenerateMipmap(TEXTURE_2D));
+        for(int32_t level = 0; level < m_levels; level++)
+            m_memory += static_cast<uint64_t>(std::max(1, m_width >> level)) * std::max(1, m_height >> level) * 4;
+        return true;
+    }
+
+    texture_2d_array::texture_2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap)
+        : m_width(width), m_height(height), m_channels(channels), m_layers(layers), m_filter(filter){
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(m_type, m_id);
+        texture_parameters(filter, wrap, m_type);
+        storage();
+    }
+
+    texture_2d_array::texture_2d_array(const std::vector<std::filesystem::path>& paths, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip)
+        : m_layers(static_cast<uint32_t>(paths.size())), m_filter(filter){
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(m_type, m_id);
+        texture_parameters(filter, wrap, m_type);
+        if(paths.empty()) return;
+
+        // The first file decides size and channels, the others are converted to its channel count
+        stbi_set_flip_vertically_on_load(flip);
+        GLenum internal_format = 0, data_format = 0;
+        for(uint32_t layer = 0; layer < m_layers; layer++){
+            int32_t width{0}, height{0}, channels{0};
+            uint8_t* pixels = stbi_load(paths[layer].string().c_str(), &width, &height, &channels, m_channels);
+            if(pixels == nullptr){
+                gapi_debug_msg("Failed to load texture layer: ", paths[layer].string());
+                continue;
+            }
+            if(m_channels == 0){
+                m_width = width;
+                m_height = height;
+                m_channels = channels;
+                storage();
+            }
+            if(width != m_width || height != m_height || !texture_formats(m_channels, internal_format, data_format)){
+                gapi_debug_msg("Texture layer doesn't match the array size: ", paths[layer].string());
+                stbi_image_free(pixels);
+                continue;
+            }
+
+            gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+            gl(glTexSubImage3D(m_type, 0, 0, 0, layer, m_width, m_height, 1, data_format, GL_UNSIGNED_BYTE, pixels));
+            gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+            stbi_image_free(pixels);
+        }
+        if(m_levels > 1) gl(glGenerateMipmap(m_type));
+    }
+
+    texture_2d_array::~texture_2d_array(){
+        state_cache::forget_texture(m_id);
+        gl(glDeleteTextures(1, &m_id));
+    }
+
+    void texture_2d_array::bind(uint32_t slot) const {
+        state_cache::texture(slot, m_type, m_id);
+    }
+
+    void texture_2d_array::unbind() const {
+        state_cache::texture(m_type, 0);
+    }
+
+    void texture_2d_array::set_layer(uint32_t layer, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels){
+        GLenum internal_format = 0, data_format = 0;
+        if(!texture_formats(m_channels, internal_format, data_format)){
+            gapi_debug_msg("Texture array has no storage yet", "");
+            return;
+        }
+        gapi_asserts(layer < m_layers && x + width <= m_width && y + height <= m_height, "Texture data exceeds texture array size");
+
+        state_cache::texture(m_type, m_id);
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        gl(glTexSubImage3D(m_type, 0, x, y, layer, width, height, 1, data_format, GL_UNSIGNED_BYTE, pixels));
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        if(m_levels > 1) gl(glGenerateMipmap(m_type));
+    }
+
+    // Every layer shares one mip chain; the texture must be bound.
+    void texture_2d_array::storage(){
+        GLenum internal_format = 0, data_format = 0;
+        bool supported = texture_formats(m_channels, internal_format, data_format);
+        gapi_asserts(supported, "Texture format not supported");
+        if(!supported || m_layers == 0) return;
+
+        m_levels = texture_levels(m_filter, m_width, m_height);
+        gl(glTexStorage3D(m_type, m_levels, internal_format, m_width, m_height, m_layers));
+
+        m_memory = 0;
+        for(int32_t level = 0; level < m_levels; level++)
+            m_memory += static_cast<uint64_t>(std::max(1, m_width >> level)) * std::max(1, m_height >> level) * m_channels * m_layers;
+    }
+
+    static GLenum attachment_internal_format(ATTACHMENT_FORMAT format){
+        switch(format){
+            case ATTACHMENT_RGBA8:              return GL_RGBA8;
+            case ATTACHMENT_RGBA16F:            return GL_RGBA16F;
+            case ATTACHMENT_DEPTH24_STENCIL8:   return GL_DEPTH24_STENCIL8;
+            case ATTACHMENT_DEPTH32F:           return GL_DEPTH_COMPONENT32F;
+            default:                            return GL_NONE;
+        }
+    }
+
+    render_texture::render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height)
+        : m_width(width), m_height(height), m_format(format){
+        gl(glGenTextures(1, &m_id));
+        state_cache::texture(TEXTURE_2D, m_id);
+        texture_parameters(TEX_FILTER_LINEAR, TEX_WRAP_CLAMP);
+        gl(glTexStorage2D(TEXTURE_2D, 1, attachment_internal_format(format), width, height));
+    }
+
+    render_texture::~render_texture(){
+        state_cache::forget_texture(m_id);
+        gl(glDeleteTextures(1, &m_id));
+    }
+
+    void render_texture::bind(uint32_t slot) const {
+        state_cache::texture(slot, GL_TEXTURE_2D, m_id);
+    }
+
+    void render_texture::unbind() const {
+        state_cache::texture(GL_TEXTURE_2D, 0);
+    }
+
+    void render_texture::set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels){
+        gapi_debug_msg("Render textures are written by drawing into their framebuffer", "");
+    }
+
+    framebuffer::framebuffer(const framebuffer_spec& spec, attachment_factory factory) : m_spec(spec), m_factory(std::move(factory)){
+        if(m_factory == nullptr) m_factory = [](ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+            return std::make_shared<render_texture>(format, width, height);
+        };
+        gl(glGenFramebuffers(1, &m_id));
+        attach();
+    }
+
+    framebuffer::~framebuffer(){
+        state_cache::forget_framebuffer(m_id);
+        gl(glDeleteFramebuffers(1, &m_id));
+    }
+
+    void framebuffer::bind() const {
+        state_cache::framebuffer(m_id);
+        state_cache::viewport(0, 0, m_spec.width, m_spec.height);
+    }
+
+    // The default framebuffer is as large as the window of the current context.
+    void framebuffer::unbind() const {
+        int32_t width{0}, height{0};
+        glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+        state_cache::framebuffer(0);
+        state_cache::viewport(0, 0, width, height);
+    }
+
+    void framebuffer::resize(int32_t width, int32_t height){
+        if(width <= 0 || height <= 0 || (width == m_spec.width && height == m_spec.height)) return;
+        m_spec.width = width;
+        m_spec.height = height;
+        attach();
+    }
+
+    // Replacing the attachments drops the previous ones, which a pooling factory takes back.
+    void framebuffer::attach(){
+        m_colors.clear();
+        m_depth = nullptr;
+
+        state_cache::framebuffer(m_id);
+        std::vector<GLenum> draw_buffers;
+        for(ATTACHMENT_FORMAT format : m_spec.colors){
+            const GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(m_colors.size());
+            m_colors.push_back(m_factory(format, m_spec.width, m_spec.height));
+            gl(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_colors.back()->id(), 0));
+            draw_buffers.push_back(attachment);
+        }
+        if(m_spec.depth != ATTACHMENT_NONE){
+            const GLenum attachment = m_spec.depth == ATTACHMENT_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            m_depth = m_factory(m_spec.depth, m_spec.width, m_spec.height);
+            gl(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_depth->id(), 0));
+        }
+
+        if(draw_buffers.empty()){
+            gl(glDrawBuffer(GL_NONE));
+        }
+        else{
+            gl(glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data()));
+        }
+
+        const GLenum status = gl(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+        gapi_asserts(status == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete");
+    }
+
+    // 8x8 grey checkerboard shown while the real pixels are on their way
+    static std::shared_ptr<const texture_2d> checker_texture(){
+        std::array<uint8_t, 8 * 8 * 4> checker{};
+        for(uint32_t i = 0; i < 64; i++){
+            uint8_t value = ((i % 8) / 4 + (i / 8) / 4) % 2 ? 0x60 : 0x90;
+            checker[i * 4 + 0] = checker[i * 4 + 1] = checker[i * 4 + 2] = value;
+            checker[i * 4 + 3] = 0xFF;
+        }
+        return std::make_shared<texture_2d>(8, 8, 4, checker.data(), TEX_FILTER_NEAREST, TEX_WRAP_REPEAT);
+    }
+
+    texture_loader::texture_loader(uint32_t workers, uint32_t upload_budget, bool keep_data) : m_upload_budget(upload_budget), m_keep_data(keep_data){
+        m_placeholder = checker_texture();
+
+        gl(glGenBuffers(1, &m_pbo));
+
+        if(workers == 0) workers = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+        for(uint32_t i = 0; i < workers; i++)
+            m_workers.emplace_back(&texture_loader::work, this);
+    }
+
+    texture_loader::~texture_loader(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for(auto& worker : m_workers) worker.join();
+
+        for(auto& decoded : m_decoded) stbi_image_free(decoded.pixels);
+        for(auto& upload : m_uploads) stbi_image_free(upload.pixels);
+        state_cache::forget_buffer(m_pbo);
+        gl(glDeleteBuffers(1, &m_pbo));
+    }
+
+    std::shared_ptr<texture_2d> texture_loader::load(const std::filesystem::path& path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip){
+        auto texture = std::make_shared<texture_2d>(filter, wrap, m_placeholder);
+        texture->m_path = path.string();
+        texture->m_flip = flip;
+        texture->m_keep_data = m_keep_data;
+        reload(texture);
+        return texture;
+    }
+
+    void texture_loader::reload(const std::shared_ptr<texture_2d>& texture){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back({texture, texture->m_path, texture->m_flip});
+        }
+        m_wake.notify_one();
+        m_pending++;
+    }
+
+    void texture_loader::work(){
+        TRIMANA_PROFILE_THREAD("texture_loader");
+        for(;;){
+            job request{};
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]{ return m_stop || !m_requests.empty(); });
+                if(m_stop) return;
+                request = std::move(m_requests.front());
+                m_requests.pop_front();
+            }
+
+            if(!request.texture.expired() && compressed_container(request.path)){
+                TRIMANA_PROFILE_SCOPE("texture_loader::decode");
+                request.compressed = std::make_shared<compressed_image>();
+                if(!load_compressed(request.path, *request.compressed)) request.compressed->levels.clear();
+            }
+            else if(!request.texture.expired()){
+                TRIMANA_PROFILE_SCOPE("texture_loader::decode");
+                // The flip flag is global in stb_image unless set per thread
+                stbi_set_flip_vertically_on_load_thread(request.flip);
+                request.pixels = stbi_load(request.path.string().c_str(), &request.width, &request.height, &request.channels, 0);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_decoded.push_back(std::move(request));
+        }
+    }
+
+    // Immutable storage can't be specified twice, so a reloaded texture trades its name for a
+    // fresh one and shows its placeholder, or the loader's, until the new upload completes.
+    void texture_loader::vacate(texture_2d& texture){
+        if(!texture.m_storage) return;
+        texture.evict(texture.m_placeholder != nullptr ? texture.m_placeholder : m_placeholder);
+    }
+
+    // Copies rows of decoded images into the orphaned unpack buffer until the budget is spent,
+    // then issues the matching glTexSubImage2D calls, which read from the buffer asynchronously.
+    void texture_loader::update(){
+        TRIMANA_PROFILE_SCOPE("texture_loader::update");
+        struct band{
+            texture_2d* texture{nullptr};
+            int32_t row{0};
+            int32_t rows{0};
+            uint32_t offset{0};
+            GLenum format{GL_NONE};
+        };
+        std::vector<band> bands;
+        std::vector<job> finished;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::move(m_decoded.begin(), m_decoded.end(), std::back_inserter(m_uploads));
+            m_decoded.clear();
+        }
+
+        // A reload right behind an upload to the same texture waits until that one is issued
+        const auto busy = [&bands](const texture_2d* texture){
+            return std::any_of(bands.begin(), bands.end(), [texture](const band& b){ return b.texture == texture; });
+        };
+
+        uint32_t used = 0, direct = 0;
+        uint8_t* staging = nullptr;
+        while(!m_uploads.empty() && used + direct < m_upload_budget){
+            job& current = m_uploads.front();
+            auto texture = current.texture.lock();
+            if(texture != nullptr && current.compressed != nullptr){
+                if(busy(texture.get())) break;
+                // Block data is already small, it goes straight to the texture in one step,
+                // from client memory so the mapped staging buffer must not be bound meanwhile
+                if(staging != nullptr) state_cache::buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                if(!current.compressed->valid()){
+                    gapi_debug_msg("Failed to load texture: ", current.path.string());
+                }
+                else{
+                    vacate(*texture);
+                    if(texture->upload(*current.compressed)) texture->m_placeholder = nullptr;
+                }
+                if(staging != nullptr) state_cache::buffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+                direct += static_cast<uint32_t>(current.compressed->data.size());
+                m_uploads.pop_front();
+                m_pending--;
+                continue;
+            }
+            GLenum internal_format = 0, data_format = 0;
+            if(texture == nullptr || current.pixels == nullptr || !texture_formats(current.channels, internal_format, data_format)){
+                if(texture != nullptr && current.compressed == nullptr) gapi_debug_msg("Failed to load texture: ", current.path.string());
+                stbi_image_free(current.pixels);
+                m_uploads.pop_front();
+                m_pending--;
+                continue;
+            }
+
+            const uint32_t pitch = static_cast<uint32_t>(current.width * current.channels);
+            if(staging == nullptr){
+                // At least one row per frame, however wide the image
+                m_pbo_size = std::max({m_pbo_size, m_upload_budget, pitch});
+                state_cache::buffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+                gl(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_pbo_size, nullptr, GL_STREAM_DRAW));
+                void* mapped = gl(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_pbo_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+                if(mapped == nullptr){
+                    state_cache::buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                    return;
+                }
+                staging = static_cast<uint8_t*>(mapped);
+            }
+
+            const uint32_t space = used < m_pbo_size ? m_pbo_size - used : 0;
+            const int32_t rows = std::min<int32_t>(current.height - current.uploaded_rows, std::max<uint32_t>(1, space / pitch));
+            if(used + rows * pitch > m_pbo_size) break;
+
+            // Only a texture whose first rows go out this frame gives up what it shows now
+            if(current.uploaded_rows == 0){
+                if(busy(texture.get())) break;
+                vacate(*texture);
+                texture->m_width = current.width;
+                texture->m_height = current.height;
+                texture->m_channels = current.channels;
+                state_cache::texture(TEXTURE_2D, texture->m_id);
+                texture->storage(internal_format);
+            }
+            std::memcpy(staging + used, current.pixels + static_cast<size_t>(current.uploaded_rows) * pitch, static_cast<size_t>(rows) * pitch);
+            bands.push_back({texture.get(), current.uploaded_rows, rows, used, data_format});
+            used += (rows * pitch + 15) & ~15u;
+            current.uploaded_rows += rows;
+
+            if(current.uploaded_rows == current.height){
+                finished.push_back(std::move(current));
+                m_uploads.pop_front();
+            }
+        }
+
+        if(staging == nullptr) return;
+        gl(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        for(const auto& b : bands){
+            state_cache::texture(TEXTURE_2D, b.texture->m_id);
+            gl(glTexSubImage2D(TEXTURE_2D, 0, 0, b.row, b.texture->m_width, b.rows, b.format, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(static_cast<uintptr_t>(b.offset))));
+        }
+        gl(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        state_cache::buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        for(auto& done : finished){
+            auto texture = done.texture.lock();
+            m_pending--;
+            if(texture == nullptr){
+                stbi_image_free(done.pixels);
+                continue;
+            }
+            if(texture->m_levels > 1){
+                state_cache::texture(TEXTURE_2D, texture->m_id);
+                gl(glGenerateMipmap(TEXTURE_2D));
+            }
+            texture->m_data = done.pixels;
+            texture->m_placeholder = nullptr;
+            if(!texture->m_keep_data) texture->release_data();
+        }
+    }
+
+    texture_residency::texture_residency(uint64_t budget, std::shared_ptr<texture_loader> loader)
+        : m_budget(budget), m_loader(std::move(loader)), m_placeholder(checker_texture()){
+    }
+
+    void texture_residency::track(const std::shared_ptr<texture_2d>& texture){
+        for(const auto& tracked : m_entries)
+            if(tracked.texture.lock() == texture) return;
+        m_entries.push_back({texture});
+    }
+
+    void texture_residency::update(){
+        TRIMANA_PROFILE_SCOPE("texture_residency::update");
+        std::erase_if(m_entries, [](const entry& tracked){ return tracked.texture.expired(); });
+
+        // Evicted textures bound since they went away come back first
+        for(auto& tracked : m_entries){
+            auto texture = tracked.texture.lock();
+            if(!tracked.evicted || texture->m_last_bind <= tracked.evicted_at) continue;
+            tracked.evicted = false;
+            m_reloads++;
+            if(m_loader != nullptr){
+                m_loader->reload(texture);
+                continue;
+            }
+            texture->load(texture->m_flip);
+            texture->m_placeholder = nullptr;
+        }
+
+        uint64_t total = stats().bytes();
+        if(total > m_budget){
+            // Only settled, file backed textures not bound since the last update can go
+            std::vector<entry*> candidates;
+            for(auto& tracked : m_entries){
+                auto texture = tracked.texture.lock();
+                if(!tracked.evicted && texture->ready() && !texture->m_path.empty() && texture->m_last_bind <= m_frame_clock)
+                    candidates.push_back(&tracked);
+            }
+            std::sort(candidates.begin(), candidates.end(), [](const entry* a, const entry* b){
+                return a->texture.lock()->m_last_bind < b->texture.lock()->m_last_bind;
+            });
+
+            for(entry* tracked : candidates){
+                if(total <= m_budget) break;
+                auto texture = tracked->texture.lock();
+                total -= texture->memory() + texture->data_memory();
+                texture->evict(m_placeholder);
+                tracked->evicted = true;
+                tracked->evicted_at = texture_2d::s_bind_clock;
+                m_evictions++;
+            }
+        }
+
+        if(total > m_budget && !m_over_budget)
+            gapi_debug_msg("Textures in use exceed the residency budget: ", std::to_string(total) + " > " + std::to_string(m_budget));
+        m_over_budget = total > m_budget;
+        m_frame_clock = texture_2d::s_bind_clock;
+    }
+
+    texture_residency_stats texture_residency::stats() const{
+        texture_residency_stats result{};
+        result.budget = m_budget;
+        result.evictions = m_evictions;
+        result.reloads = m_reloads;
+        for(const auto& tracked : m_entries){
+            auto texture = tracked.texture.lock();
+            if(texture == nullptr) continue;
+            result.tracked++;
+            if(tracked.evicted) result.evicted++;
+            else result.resident++;
+            result.cpu_bytes += texture->data_memory();
+            result.gpu_bytes += texture->memory();
+        }
+        return result;
+    }
+
+    readback::readback(uint32_t buffers, uint32_t workers) : m_slots(std::max(buffers, 1u)){
+        for(auto& target : m_slots) gl(glGenBuffers(1, &target.pbo));
+        for(uint32_t i = 0; i < std::max(workers, 1u); i++)
+            m_workers.emplace_back(&readback::work, this);
+    }
+
+    readback::~readback(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for(auto& worker : m_workers) worker.join();
+
+        for(auto& target : m_slots){
+            if(target.fence != nullptr) gl(glDeleteSync(target.fence));
+            state_cache::forget_buffer(target.pbo);
+            gl(glDeleteBuffers(1, &target.pbo));
+        }
+    }
+
+    void readback::read(const gapi::texture& source, readback_callback callback){
+        slot& target = acquire(source.width(), source.height(), std::move(callback));
+        state_cache::texture(GL_TEXTURE_2D, source.id());
+        gl(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        target.fence = gl(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        state_cache::buffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void readback::read(const gapi::framebuffer& source, readback_callback callback, uint32_t attachment){
+        read(*source.color(attachment), std::move(callback));
+    }
+
+    void readback::read_window(readback_callback callback){
+        int32_t width{0}, height{0};
+        glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+        slot& target = acquire(width, height, std::move(callback));
+        state_cache::framebuffer(0);
+        gl(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        target.fence = gl(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        state_cache::buffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Leaves the slot's pack buffer bound, sized for the copy that follows.
+    readback::slot& readback::acquire(int32_t width, int32_t height, readback_callback callback){
+        slot& target = m_slots[m_next];
+        m_next = (m_next + 1) % static_cast<uint32_t>(m_slots.size());
+        if(target.fence != nullptr){
+            // Only a copy still in flight blocks; a finished one is delivered right away
+            const GLenum status = gl(glClientWaitSync(target.fence, 0, 0));
+            if(status == GL_TIMEOUT_EXPIRED) m_stats.stalls++;
+            deliver(target);
+        }
+
+        const uint32_t size = static_cast<uint32_t>(width) * static_cast<uint32_t>(height) * 4;
+        state_cache::buffer(GL_PIXEL_PACK_BUFFER, target.pbo);
+        if(target.size < size){
+            gl(glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ));
+            target.size = size;
+        }
+        target.width = width;
+        target.height = height;
+        target.sequence = m_sequence++;
+        target.callback = std::move(callback);
+        m_stats.reads++;
+        return target;
+    }
+
+    // Waits for the copy if it hasn't finished, then flips the rows while copying them out.
+    void readback::deliver(slot& target){
+        GLenum status = gl(glClientWaitSync(target.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));
+        while(status == GL_TIMEOUT_EXPIRED){
+            status = gl(glClientWaitSync(target.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));
+        }
+        gl(glDeleteSync(target.fence));
+        target.fence = nullptr;
+
+        readback_image image{target.width, target.height, target.sequence};
+        const size_t pitch = static_cast<size_t>(target.width) * 4;
+        state_cache::buffer(GL_PIXEL_PACK_BUFFER, target.pbo);
+        const void* mapped = gl(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pitch * target.height, GL_MAP_READ_BIT));
+        if(mapped != nullptr){
+            const auto* rows = static_cast<const uint8_t*>(mapped);
+            image.pixels.resize(pitch * target.height);
+            for(int32_t row = 0; row < target.height; row++)
+                std::memcpy(image.pixels.data() + pitch * row, rows + pitch * (target.height - 1 - row), pitch);
+            gl(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+        }
+        else gapi_debug_msg("Failed to map readback buffer: ", std::to_string(target.sequence));
+        state_cache::buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        readback_callback callback = std::move(target.callback);
+        target.callback = nullptr;
+        m_stats.delivered++;
+        if(callback != nullptr) callback(std::move(image));
+    }
+
+    void readback::update(){
+        TRIMANA_PROFILE_SCOPE("readback::update");
+        // Callbacks may read again, which moves m_next
+        const uint32_t first = m_next;
+        const uint32_t count = static_cast<uint32_t>(m_slots.size());
+        for(uint32_t i = 0; i < count; i++){
+            slot& target = m_slots[(first + i) % count];
+            if(target.fence == nullptr) continue;
+            const GLenum status = gl(glClientWaitSync(target.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+            if(status == GL_TIMEOUT_EXPIRED) break;
+            deliver(target);
+        }
+    }
+
+    readback_callback readback::png(std::filesystem::path path){
+        return [this, path = std::move(path)](readback_image image){
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_encodes.push_back({path, std::move(image)});
+            }
+            m_wake.notify_one();
+        };
+    }
+
+    void readback::work(){
+        TRIMANA_PROFILE_THREAD("readback");
+        for(;;){
+            encode job{};
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this]{ return m_stop || !m_encodes.empty(); });
+                if(m_encodes.empty()) return;
+                job = std::move(m_encodes.front());
+                m_encodes.pop_front();
+            }
+
+            bool written{false};
+            {
+                TRIMANA_PROFILE_SCOPE("readback::encode");
+                const readback_image& image = job.image;
+                written = !image.pixels.empty() &&
+                    stbi_write_png(job.path.string().c_str(), image.width, image.height, 4, image.pixels.data(), image.width * 4) != 0;
+            }
+            if(!written) gapi_debug_msg("Failed to write capture: ", job.path.string());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(written) m_stats.encoded++;
+            else m_stats.failed++;
+        }
+    }
+
+    readback_stats readback::stats() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    gpu_profiler::gpu_profiler(uint32_t latency) : m_frames(std::max(latency, 2u)){
+    }
+
+    gpu_profiler::~gpu_profiler(){
+        if(s_current == this) s_current = nullptr;
+        for(auto& target : m_frames){
+            if(target.queries.empty()) continue;
+            gl(glDeleteQueries(static_cast<GLsizei>(target.queries.size()), target.queries.data()));
+        }
+    }
+
+    void gpu_profiler::begin_frame(std::string_view name){
+        TRIMANA_PROFILE_SCOPE("gpu_profiler::begin_frame");
+        if(m_recording) end_frame();
+
+        // Oldest first, the set about to be reused is the oldest; once a frame isn't finished the later ones aren't either
+        const uint32_t count = static_cast<uint32_t>(m_frames.size());
+        for(uint32_t i = 0; i < count; i++){
+            frame& target = m_frames[(m_index + i) % count];
+            if(target.pending && !collect(target)) break;
+        }
+
+        frame& current = m_frames[m_index];
+        if(current.pending){
+            current.pending = false;
+            m_dropped++;
+        }
+        current.used = 0;
+        current.records.clear();
+        m_recording = true;
+        s_current = this;
+        begin(name);
+    }
+
+    void gpu_profiler::end_frame(){
+        if(!m_recording) return;
+        while(!m_open.empty()) end();
+
+        m_frames[m_index].pending = true;
+        m_index = (m_index + 1) % static_cast<uint32_t>(m_frames.size());
+        m_recording = false;
+        if(s_current == this) s_current = nullptr;
+    }
+
+    void gpu_profiler::begin(std::string_view name){
+        if(!m_recording) return;
+        frame& current = m_frames[m_index];
+        record entry{};
+        entry.zone = zone(name, static_cast<uint32_t>(m_open.size()));
+        entry.begin_query = query(current);
+        gl(glQueryCounter(current.queries[entry.begin_query], GL_TIMESTAMP));
+        entry.cpu_begin = std::chrono::steady_clock::now();
+        m_open.push_back(static_cast<uint32_t>(current.records.size()));
+        current.records.push_back(entry);
+    }
+
+    void gpu_profiler::end(){
+        if(!m_recording || m_open.empty()) return;
+        frame& current = m_frames[m_index];
+        record& entry = current.records[m_open.back()];
+        m_open.pop_back();
+        entry.end_query = query(current);
+        gl(glQueryCounter(current.queries[entry.end_query], GL_TIMESTAMP));
+        entry.cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.cpu_begin).count();
+    }
+
+    uint32_t gpu_profiler::query(frame& target){
+        if(target.used == target.queries.size()){
+            uint32_t id{0};
+            gl(glGenQueries(1, &id));
+            target.queries.push_back(id);
+        }
+        return target.used++;
+    }
+
+    uint32_t gpu_profiler::zone(std::string_view name, uint32_t depth){
+        auto found = m_lookup.find(std::string(name));
+        if(found != m_lookup.end()) return found->second;
+
+        const uint32_t index = static_cast<uint32_t>(m_zones.size());
+        gpu_zone_stats created{};
+        created.name = std::string(name);
+        created.depth = depth;
+        m_zones.push_back(std::move(created));
+        m_lookup.emplace(std::string(name), index);
+        return index;
+    }
+
+    // Queries complete in order, so the frame's last one being available means all of them are.
+    bool gpu_profiler::collect(frame& target){
+        if(target.used > 0){
+            GLint available{0};
+            gl(glGetQueryObjectiv(target.queries[target.used - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+            if(available == 0) return false;
+        }
+
+        m_frame_gpu.assign(m_zones.size(), -1.0);
+        m_frame_cpu.assign(m_zones.size(), 0.0);
+        for(const record& entry : target.records){
+            GLuint64 begin{0}, end{0};
+            gl(glGetQueryObjectui64v(target.queries[entry.begin_query], GL_QUERY_RESULT, &begin));
+            gl(glGetQueryObjectui64v(target.queries[entry.end_query], GL_QUERY_RESULT, &end));
+            double& gpu = m_frame_gpu[entry.zone];
+            gpu = std::max(gpu, 0.0) + (end > begin ? static_cast<double>(end - begin) / 1.0e6 : 0.0);
+            m_frame_cpu[entry.zone] += entry.cpu_ms;
+        }
+
+        for(size_t i = 0; i < m_zones.size(); i++){
+            if(m_frame_gpu[i] < 0.0) continue;
+            gpu_zone_stats& stats = m_zones[i];
+            stats.gpu_ms = m_frame_gpu[i];
+            stats.cpu_ms = m_frame_cpu[i];
+            const double weight = stats.frames == 0 ? 1.0 : average_weight;
+            stats.gpu_average_ms += (stats.gpu_ms - stats.gpu_average_ms) * weight;
+            stats.cpu_average_ms += (stats.cpu_ms - stats.cpu_average_ms) * weight;
+            stats.frames++;
+        }
+        target.pending = false;
+        return true;
     }
 
     void api::init() {
-        gl(glEnable(GL_BLEND));
-        gl(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+        state_cache::blend(true);
+        state_cache::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        int32_t max_texture_slots{0};
+        gl(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_texture_slots));
+        m_max_texture_slots = static_cast<uint32_t>(max_texture_slots);
+        m_draw_parameters = GLEW_ARB_shader_draw_parameters;
+    }
+
+    static GLenum index_type(const gapi::vertex_array& va){
+        return va.index()->type() == INDEX_U16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
     }
+
     void api::draw(const std::shared_ptr<gapi::vertex_array>& va) {
         auto& index_buffer = va->index();
-        gl(glDrawElements(GL_TRIANGLES, index_buffer->count(), GL_UNSIGNED_INT, nullptr));
+        gl(glDrawElements(GL_TRIANGLES, index_buffer->count(), index_type(*va), nullptr));
+    }
+
+    void api::draw(const gapi::vertex_array& va, uint32_t count) {
+        gl(glDrawElements(GL_TRIANGLES, count, index_type(va), nullptr));
+    }
+
+    void api::draw(const gapi::vertex_array& va, uint32_t count, uint32_t base_vertex) {
+        gl(glDrawElementsBaseVertex(GL_TRIANGLES, count, index_type(va), nullptr, base_vertex));
+    }
+
+    void api::draw_instanced(const gapi::vertex_array& va, uint32_t instance_count) {
+        gl(glDrawElementsInstanced(GL_TRIANGLES, va.index()->count(), index_type(va), nullptr, instance_count));
+    }
+
+    void api::draw_indirect(const gapi::vertex_array& va, const gapi::indirect_buffer& commands, uint32_t first, uint32_t draw_count) {
+        commands.bind();
+        const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(first) * sizeof(draw_indirect_command));
+        gl(glMultiDrawElementsIndirect(GL_TRIANGLES, index_type(va), offset, draw_count, 0));
+    }
+
+    void api::draw(const gapi::vertex_array& va, const draw_indirect_command& command) {
+        const size_t index_size = va.index()->type() == INDEX_U16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(command.first_index) * index_size);
+        gl(glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, index_type(va), offset, command.instance_count, command.base_vertex, command.base_instance));
     }
 
     void api::clear() {
@@ -468,7 +2290,12 @@ namespace gapi::opengl{
     }
 
     void api::clear_color(float r, float g, float b, float a) {
-        gl(glClearColor(r, g, b, a));
+        state_cache::clear_color({r, g, b, a});
+    }
+
+    void api::unbind_texture(uint32_t slot) {
+        state_cache::texture(slot, GL_TEXTURE_2D, 0);
+        state_cache::texture(slot, GL_TEXTURE_2D_ARRAY, 0);
     }
 
     std::shared_ptr<context> make_context(GLFWwindow* window) noexcept{
@@ -479,24 +2306,91 @@ namespace gapi::opengl{
         return std::make_shared<gapi::opengl::vertex_buffer>(v, s, t);
     }
 
+    std::shared_ptr<vertex_buffer> make_vertex(uint32_t s, DRAW t) noexcept{
+        return std::make_shared<gapi::opengl::vertex_buffer>(s, t);
+    }
+
+    std::shared_ptr<stream_buffer> make_stream(uint32_t frame_size, uint32_t frames) noexcept{
+        return std::make_shared<stream_buffer>(frame_size, frames);
+    }
+
     std::shared_ptr<index_buffer> make_index(uint32_t* i, size_t c, DRAW t) noexcept{
+        const INDEX type = i != nullptr ? index_type_for({i, c}) : INDEX_U32;
+        return std::make_shared<index_buffer>(i, c, t, type);
+    }
+
+    std::shared_ptr<index_buffer> make_index(uint16_t* i, size_t c, DRAW t) noexcept{
         return std::make_shared<index_buffer>(i, c, t);
     }
 
+    std::shared_ptr<uniform_buffer> make_uniform(uint32_t s, uint32_t binding, DRAW t) noexcept{
+        return std::make_shared<uniform_buffer>(s, binding, t);
+    }
+
+    std::shared_ptr<indirect_buffer> make_indirect() noexcept{
+        return std::make_shared<indirect_buffer>();
+    }
+
+    std::shared_ptr<storage_buffer> make_storage(uint32_t s, uint32_t binding) noexcept{
+        return std::make_shared<storage_buffer>(s, binding);
+    }
+
     std::shared_ptr<vertex_array> make_array() noexcept{
         return std::make_shared<vertex_array>();
     }
 
-    std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip) noexcept{
-        return std::make_shared<texture_2d>(path, filter, wrap, flip);
+    std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip, bool keep_data) noexcept{
+        return std::make_shared<texture_2d>(path, filter, wrap, flip, keep_data);
     }
 
-    std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& path) noexcept{
-        return std::make_shared<shader>(sname, path);
+    std::shared_ptr<texture_2d> make_texture2d(int32_t width, int32_t height, int32_t channels, const uint8_t* pixels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap) noexcept{
+        return std::make_shared<texture_2d>(width, height, channels, pixels, filter, wrap);
     }
 
-    std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment) noexcept{
-        return std::make_shared<shader>(sname, vertex, fragment);
+    std::shared_ptr<texture_2d_array> make_texture2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap) noexcept{
+        return std::make_shared<texture_2d_array>(width, height, layers, channels, filter, wrap);
+    }
+
+    std::shared_ptr<texture_2d_array> make_texture2d_array(const std::vector<std::filesystem::path>& paths, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip) noexcept{
+        return std::make_shared<texture_2d_array>(paths, filter, wrap, flip);
+    }
+
+    std::shared_ptr<render_texture> make_render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height) noexcept{
+        return std::make_shared<render_texture>(format, width, height);
+    }
+
+    std::shared_ptr<framebuffer> make_framebuffer(const framebuffer_spec& spec, attachment_factory factory) noexcept{
+        return std::make_shared<framebuffer>(spec, std::move(factory));
+    }
+
+    std::shared_ptr<texture_loader> make_texture_loader(uint32_t workers, uint32_t upload_budget, bool keep_data) noexcept{
+        return std::make_shared<texture_loader>(workers, upload_budget, keep_data);
+    }
+
+    std::shared_ptr<texture_residency> make_texture_residency(uint64_t budget, std::shared_ptr<texture_loader> loader) noexcept{
+        return std::make_shared<texture_residency>(budget, std::move(loader));
+    }
+
+    std::shared_ptr<readback> make_readback(uint32_t buffers, uint32_t workers) noexcept{
+        return std::make_shared<readback>(buffers, workers);
+    }
+
+    std::shared_ptr<gpu_profiler> make_gpu_profiler(uint32_t latency) noexcept{
+        return std::make_shared<gpu_profiler>(latency);
+    }
+
+    std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& path, const shader_defines& defines) noexcept{
+        return std::make_shared<shader>(sname, path, defines);
+    }
+
+    std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment, const shader_defines& defines) noexcept{
+        return std::make_shared<shader>(sname, vertex, fragment, defines);
+    }
+
+    gapi::shader_factory make_shader_factory() noexcept{
+        return [](const std::string& name, const std::filesystem::path& path, const shader_defines& defines) -> std::shared_ptr<gapi::shader> {
+            return make_shader(name, path, defines);
+        };
     }
 
 }
\ No newline at end of file
@@ -9,8 +9,16 @@
 #undef APIENTRY
 #endif
 
+#include <future>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
 #include <stb_image.h>
 #include "gapi.hpp"
+#include "gapi_compressed_texture.hpp"
 
 namespace gapi::opengl{
 
@@ -30,7 +38,10 @@ namespace gapi::opengl{
         INT             = GL_INT,
         UINT            = GL_UNSIGNED_INT,
         FLOAT           = GL_FLOAT,
-        DOUBLE          = GL_DOUBLE
+        HALF_FLOAT      = GL_HALF_FLOAT,
+        DOUBLE          = GL_DOUBLE,
+        INT_2_10_10_10  = GL_INT_2_10_10_10_REV,
+        UINT_2_10_10_10 = GL_UNSIGNED_INT_2_10_10_10_REV
     };
 
     enum DRAW_MODE : GLenum {
@@ -117,31 +128,151 @@ namespace gapi::opengl{
 
         public:
             vertex_buffer(float* v, uint32_t s, DRAW t);
+            vertex_buffer(uint32_t s, DRAW t);
             virtual ~vertex_buffer();
 
+            using gapi::vertex_buffer::set_data;
+            using gapi::vertex_buffer::orphan;
             virtual void bind() const override;
             virtual void unbind() const override;
+            virtual void set_data(const void* data, uint32_t size) override;
+            virtual void set_data(uint32_t offset, std::span<const std::byte> data) override;
+            virtual void orphan(std::span<const std::byte> data) override;
+            virtual void resize(uint32_t size) override;
+            inline virtual uint32_t size() const override { return m_size; }
             virtual void configure_layout(const gapi::buffer_layout& layout) override { m_layout = layout; };
             virtual const gapi::buffer_layout& layout() const override { return m_layout; };
 
         private:
             uint32_t m_id{0};
+            uint32_t m_size{0};
+            DRAW m_usage{DRAW_STATIC};
+            gapi::buffer_layout m_layout{};
+    };
+
+    class stream_buffer final : public gapi::stream_buffer {
+
+        public:
+            stream_buffer(uint32_t frame_size, uint32_t frames);
+            stream_buffer(const stream_buffer&) = delete;
+            stream_buffer& operator=(const stream_buffer&) = delete;
+            virtual ~stream_buffer();
+
+            using gapi::vertex_buffer::set_data;
+            using gapi::vertex_buffer::orphan;
+            virtual void bind() const override;
+            virtual void unbind() const override;
+            virtual void set_data(const void* data, uint32_t size) override;
+            virtual void set_data(uint32_t offset, std::span<const std::byte> data) override;
+            virtual void orphan(std::span<const std::byte> data) override;
+            virtual void resize(uint32_t size) override;
+            inline virtual uint32_t size() const override { return m_frame_size * frames(); }
+            virtual void configure_layout(const gapi::buffer_layout& layout) override { m_layout = layout; };
+            virtual const gapi::buffer_layout& layout() const override { return m_layout; };
+
+            virtual void begin_frame() override;
+            virtual void end_frame() override;
+            virtual stream_allocation reserve(uint32_t size, uint32_t alignment) override;
+            virtual void commit(uint32_t size) override;
+            virtual uint32_t remaining(uint32_t alignment) const override;
+
+            inline virtual uint32_t frame_size() const override { return m_frame_size; }
+            inline virtual uint32_t frames() const override { return static_cast<uint32_t>(m_fences.size()); }
+            inline virtual uint32_t stalls() const override { return m_stalls; }
+
+        private:
+            void advance();
+            bool wait(GLsync& fence);
+
+        private:
+            uint32_t m_id{0};
+            uint8_t* m_mapped{nullptr};
+            uint32_t m_frame_size{0};
+            uint32_t m_frame{0};
+            uint32_t m_cursor{0};
+            uint32_t m_reserved{0};
+            uint32_t m_stalls{0};
+            std::vector<GLsync> m_fences{};
             gapi::buffer_layout m_layout{};
     };
 
     class index_buffer final : public gapi::index_buffer {
 
         public:
-            index_buffer(uint32_t* i, size_t c, DRAW t);
+            index_buffer(uint32_t* i, size_t c, DRAW t, INDEX type = INDEX_U32);
+            index_buffer(uint16_t* i, size_t c, DRAW t);
             virtual ~index_buffer();
 
             void bind() const override;
             void unbind() const override;
-            inline size_t count() const override { return m_count; }
+            inline uint32_t count() const override { return m_count; }
+            inline INDEX type() const override { return m_type; }
+
+            virtual void set_data(uint32_t offset, std::span<const uint32_t> indices) override;
+            virtual void orphan(std::span<const uint32_t> indices) override;
+            virtual void resize(uint32_t count) override;
+            inline virtual uint32_t capacity() const override { return m_capacity; }
+
+        private:
+            void write(uint32_t offset, std::span<const uint32_t> indices);
+
+        private:
+            uint32_t m_id{0};
+            uint32_t m_count{0};
+            uint32_t m_capacity{0};
+            DRAW m_usage{DRAW_STATIC};
+            INDEX m_type{INDEX_U32};
+    };
+
+    class uniform_buffer final : public gapi::uniform_buffer {
+
+        public:
+            uniform_buffer(uint32_t s, uint32_t binding, DRAW t);
+            virtual ~uniform_buffer();
+
+            using gapi::uniform_buffer::set_data;
+            virtual void bind() const override;
+            virtual void set_data(const void* data, uint32_t size, uint32_t offset = 0) override;
+            inline virtual uint32_t binding() const override { return m_binding; }
+            inline virtual uint32_t size() const override { return m_size; }
 
         private:
             uint32_t m_id{0};
-            size_t m_count{0};
+            uint32_t m_size{0};
+            uint32_t m_binding{0};
+    };
+
+    class indirect_buffer final : public gapi::indirect_buffer {
+
+        public:
+            indirect_buffer();
+            virtual ~indirect_buffer();
+
+            virtual void bind() const override;
+            virtual void unbind() const override;
+            virtual void set_data(std::span<const draw_indirect_command> commands) override;
+            inline virtual uint32_t capacity() const override { return m_capacity; }
+
+        private:
+            uint32_t m_id{0};
+            uint32_t m_capacity{0};
+    };
+
+    class storage_buffer final : public gapi::storage_buffer {
+
+        public:
+            storage_buffer(uint32_t s, uint32_t binding);
+            virtual ~storage_buffer();
+
+            virtual void bind() const override;
+            virtual void set_data(const void* data, uint32_t size) override;
+            inline virtual uint32_t binding() const override { return m_binding; }
+            inline virtual uint32_t size() const override { return m_size; }
+
+        private:
+            uint32_t m_id{0};
+            uint32_t m_size{0};
+            uint32_t m_binding{0};
     };
 
     class vertex_array final : public gapi::vertex_array {
@@ -152,6 +283,7 @@ namespace gapi::opengl{
 
             void bind() const override;
             void unbind() const override;
+            inline uint32_t id() const override { return m_id; }
             void emplace_vertex(const std::shared_ptr<gapi::vertex_buffer>& vb) override;
             void emplace_index(const std::shared_ptr<gapi::index_buffer>& ib) override;
             inline const std::vector<std::shared_ptr<gapi::vertex_buffer>>& vertexs() const override { return m_vertex_buffers; }
@@ -159,50 +291,205 @@ namespace gapi::opengl{
 
         private:
             uint32_t m_id{0};
+            uint32_t m_attribute_index{0};
             std::vector<std::shared_ptr<gapi::vertex_buffer>> m_vertex_buffers{};
             std::shared_ptr<gapi::index_buffer> m_index_buffer{};
     };
 
+    struct state_cache_stats{
+        uint64_t issued{0};
+        uint64_t elided{0};
+    };
+
+    // Shadow of the bindings of the one GL context: program, vertex array, buffer targets, active
+    // unit and per-unit textures, blending and clear color. Binds that wouldn't change anything
+    // never reach the driver. Every bind in this backend goes through it, so code that changes
+    // the same state behind its back must call invalidate() afterwards.
+    class state_cache{
+
+        public:
+            static constexpr uint32_t max_units = 32;
+            static constexpr uint32_t max_indexed = 16;
+
+            static void program(uint32_t id);
+            static void vertex_array(uint32_t id);
+            static void buffer(GLenum target, uint32_t id);
+            // Also binds the generic target, as glBindBufferBase does.
+            static void buffer_base(GLenum target, uint32_t index, uint32_t id);
+            // Makes unit the active one and binds the texture there.
+            static void texture(uint32_t unit, GLenum target, uint32_t id);
+            // Binds on whichever unit is active, for uploads that don't care which one.
+            static void texture(GLenum target, uint32_t id);
+            static void blend(bool enabled);
+            static void blend_func(GLenum source, GLenum destination);
+            static void clear_color(const glm::vec4& color);
+            static void framebuffer(uint32_t id);
+            static void viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+
+            // GL unbinds deleted objects and may hand their names out again.
+            static void forget_buffer(uint32_t id);
+            static void forget_texture(uint32_t id);
+            static void forget_vertex_array(uint32_t id);
+            static void forget_framebuffer(uint32_t id);
+
+            static void invalidate();
+            [[nodiscard]] static const state_cache_stats& stats() { return s_stats; }
+            static void reset_stats() { s_stats = {}; }
+
+        private:
+            static constexpr uint32_t s_unknown = 0xFFFFFFFF;
+            static constexpr uint32_t s_buffer_targets = 8;
+            static constexpr uint32_t s_texture_targets = 4;
+
+            static bool change(uint32_t& shadow, uint32_t value);
+            static void active(uint32_t unit);
+
+        private:
+            inline static uint32_t s_program{s_unknown};
+            inline static uint32_t s_vertex_array{s_unknown};
+            inline static uint32_t s_buffers[s_buffer_targets]{};
+            inline static uint32_t s_uniform_bases[max_indexed]{};
+            inline static uint32_t s_storage_bases[max_indexed]{};
+            inline static uint32_t s_active_unit{s_unknown};
+            inline static uint32_t s_textures[max_units][s_texture_targets]{};
+            inline static uint32_t s_blend{s_unknown};
+            inline static uint32_t s_blend_source{s_unknown};
+            inline static uint32_t s_blend_destination{s_unknown};
+            inline static glm::vec4 s_clear_color{-1.0f};
+            inline static bool s_clear_color_known{false};
+            inline static uint32_t s_framebuffer{s_unknown};
+            inline static std::array<int32_t, 4> s_viewport{-1, -1, -1, -1};
+            inline static state_cache_stats s_stats{};
+    };
+
+    struct program_cache_stats{
+        uint32_t hits{0};
+        uint32_t misses{0};
+        uint32_t rejected{0};
+    };
+
+    // Linked program binaries kept on disk, keyed by the shader sources and the driver that
+    // produced them. Stays disabled until configure() is given a usable directory.
+    class program_cache{
+
+        public:
+            static void configure(const std::filesystem::path& directory, const gapi::info& info);
+            static void disable() { s_enabled = false; }
+            [[nodiscard]] static bool enabled() { return s_enabled; }
+            [[nodiscard]] static const program_cache_stats& stats() { return s_stats; }
+
+            [[nodiscard]] static uint64_t key(const std::unordered_map<SHADER_TYPE, std::string>& sources);
+            [[nodiscard]] static bool load(uint32_t program, uint64_t key);
+            static void store(uint32_t program, uint64_t key);
+
+        private:
+            static std::filesystem::path path(uint64_t key);
+
+        private:
+            inline static std::filesystem::path s_directory{};
+            inline static uint64_t s_device{0};
+            inline static bool s_enabled{false};
+            inline static program_cache_stats s_stats{};
+    };
+
     class shader final : public gapi::shader {
 
         private:
-            uint32_t validator(const std::string& n) const;
-            void compile(std::unordered_map<SHADER_TYPE, std::string> sources);
+            using stage_sources = std::unordered_map<SHADER_TYPE, std::string>;
+
+            struct uniform_info{
+                uint32_t hash{0};
+                int32_t location{-1};
+                GLenum type{GL_NONE};
+                int32_t size{0};
+            };
+
+            struct rebuild{
+                stage_sources sources{};
+                std::vector<std::filesystem::path> files{};
+            };
+
+            void reflect() const;
+            int32_t location(uniform_handle h) const;
+            void compile(stage_sources sources);
+            uint32_t link(const stage_sources& sources, uint64_t key, std::vector<uint32_t>& stages) const;
+            bool linked(uint32_t program, const std::vector<uint32_t>& stages) const;
+            void release(uint32_t program, std::vector<uint32_t>& stages) const;
+            void carry(uint32_t program, const std::vector<uniform_info>& previous) const;
+            stage_sources build(std::vector<std::filesystem::path>& files) const;
             std::string read_file(const std::filesystem::path& file_path) const;
-            std::unordered_map<SHADER_TYPE, std::string> pre_process(const std::string& src) const;
+            stage_sources pre_process(const std::string& src) const;
+            std::string expand(const std::string& src, const std::filesystem::path& directory, const shader_defines& defines, std::vector<std::filesystem::path>& files) const;
+            std::string include(const std::string& src, const std::filesystem::path& directory, std::vector<std::filesystem::path>& included) const;
 
         public:
-            shader(const std::string& sname, const std::filesystem::path& path);
-            shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment);
+            shader(const std::string& sname, const std::filesystem::path& path, const shader_defines& defines = {});
+            shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment, const shader_defines& defines = {});
             virtual ~shader();
 
             void bind() const override;
             void unbind() const override;
             inline virtual const std::string& name() const override { return m_name; }
+            virtual bool ready() const override;
+            virtual void resolve() const override;
+            inline virtual const std::vector<std::filesystem::path>& sources() const override { return m_files; }
+            virtual void reload() override;
+            virtual bool swap() override;
+
+            using gapi::shader::uniform;
+            virtual uniform_handle handle(std::string_view n) const override;
+            virtual uniform_handle handle(uniform_hash h) const override;
+            virtual bool uniform(uniform_handle h, uint32_t v) const override;
+            virtual bool uniform(uniform_handle h, float v) const override;
+            virtual bool uniform(uniform_handle h, float x, float y) const override;
+            virtual bool uniform(uniform_handle h, float x, float y, float z) const override;
+            virtual bool uniform(uniform_handle h, float x, float y, float z, float w) const override;
+            virtual bool uniform(uniform_handle h, const glm::vec2& v) const override;
+            virtual bool uniform(uniform_handle h, const glm::vec3& v) const override;
+            virtual bool uniform(uniform_handle h, const glm::vec4& v) const override;
+            virtual bool uniform(uniform_handle h, const glm::mat2& v) const override;
+            virtual bool uniform(uniform_handle h, const glm::mat3& v) const override;
+            virtual bool uniform(uniform_handle h, const glm::mat4& v) const override;
+            virtual bool uniform(uniform_handle h, const int32_t* v, uint32_t count) const override;
+            inline virtual uint32_t id() const override { return m_id; }
+            inline int32_t uniformloc(std::string_view n) const { return handle(n).location; }
 
-            virtual bool uniform(const std::string& n, uint32_t v) const override;
-            virtual bool uniform(const std::string& n, float v) const override;
-            virtual bool uniform(const std::string& n, float x, float y) const override;
-            virtual bool uniform(const std::string& n, float x, float y, float z) const override;
-            virtual bool uniform(const std::string& n, float x, float y, float z, float w) const override;
-            virtual bool uniform(const std::string& n, const glm::vec2& v) const override;
-            virtual bool uniform(const std::string& n, const glm::vec3& v) const override;
-            virtual bool uniform(const std::string& n, const glm::vec4& v) const override;
-            virtual bool uniform(const std::string& n, const glm::mat2& v) const override;
-            virtual bool uniform(const std::string& n, const glm::mat3& v) const override;
-            virtual bool uniform(const std::string& n, const glm::mat4& v) const override;
-            inline uint32_t id() const { return m_id; }
-            inline uint32_t uniformloc(const std::string& n) const { return glGetUniformLocation(m_id, n.c_str()); }
+        public:
+            // Set by context::init when GL_KHR_parallel_shader_compile is available.
+            inline static bool s_parallel_compile{false};
 
         private:
             uint32_t m_id{0};
             std::string m_name{};
+            mutable std::vector<uniform_info> m_uniforms{};
+            mutable std::vector<uint32_t> m_stages{};
+            mutable bool m_pending{false};
+            // Bumped by every swap(), handles of an older program are resolved again.
+            uint32_t m_generation{0};
+            uint64_t m_cache_key{0};
+
+            std::vector<std::filesystem::path> m_paths{};
+            shader_defines m_defines{};
+            std::vector<std::filesystem::path> m_files{};
+
+            uint32_t m_next{0};
+            std::vector<uint32_t> m_next_stages{};
+            std::vector<std::filesystem::path> m_next_files{};
+            uint64_t m_next_key{0};
+            bool m_stale{false};
+            // Declared last so its destructor joins the worker before the members it reads go away.
+            std::future<rebuild> m_rebuild{};
     };
 
     class texture_2d final : public gapi::texture {
 
         public:
-            texture_2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip = true);
+            // Without keep_data the decoded copy is dropped once it is on the GPU and data() returns null.
+            texture_2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip = true, bool keep_data = true);
+            // GPU only texture from tightly packed pixels, data() stays null.
+            texture_2d(int32_t width, int32_t height, int32_t channels, const uint8_t* pixels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap);
+            // Empty texture filled later by texture_loader, binds the placeholder until then.
+            texture_2d(TEXTURE_FILTER filter, TEXTURE_WRAP wrap, std::shared_ptr<const texture_2d> placeholder);
             virtual ~texture_2d();
 
             virtual void bind(uint32_t slot = 0) const override;
@@ -213,8 +500,29 @@ namespace gapi::opengl{
             [[maybe_unused]] virtual int32_t height() const override { return m_height; }
             [[maybe_unused]] virtual int32_t channels() const override { return m_channels; }
             [[maybe_unused]] virtual uint8_t* data() const override { return m_data; }
-        
+            virtual bool ready() const override { return m_placeholder == nullptr; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override;
+            // GPU memory of every allocated level, block compressed textures report their compressed size.
+            [[nodiscard]] inline uint64_t memory() const { return m_memory; }
+            // Size of the decoded copy kept for data(), zero once released.
+            [[nodiscard]] inline uint64_t data_memory() const { return m_data ? static_cast<uint64_t>(m_width) * m_height * m_channels : 0; }
+            [[nodiscard]] inline int32_t levels() const { return m_levels; }
+            // Frees the decoded copy, data() returns null afterwards.
+            void release_data();
+
         private:
+            friend class texture_loader;
+            friend class texture_residency;
+
+            void load(bool flip);
+            void storage(GLenum internal_format);
+            bool upload(const compressed_image& image);
+            void evict(std::shared_ptr<const texture_2d> placeholder);
+
+        private:
+            // Advanced by every bind(), gives textures their least recently used order.
+            inline static uint64_t s_bind_clock{0};
+
             int32_t m_width{0};
             int32_t m_height{0};
             int32_t m_channels{0};
@@ -222,6 +530,383 @@ namespace gapi::opengl{
             std::string m_path{};
             uint8_t* m_data{nullptr};
             TEXTURE_TYPE m_type{TEXTURE_2D};
+            TEXTURE_FILTER m_filter{TEX_FILTER_LINEAR};
+            TEXTURE_WRAP m_wrap{TEX_WRAP_REPEAT};
+            bool m_flip{true};
+            bool m_keep_data{true};
+            mutable uint64_t m_last_bind{0};
+            int32_t m_levels{1};
+            uint64_t m_memory{0};
+            bool m_compressed{false};
+            // Immutable storage is allocated, only evict() gives the texture a name without it again.
+            bool m_storage{false};
+            std::shared_ptr<const texture_2d> m_placeholder{nullptr};
+    };
+
+    class texture_2d_array final : public gapi::texture_array {
+
+        public:
+            // Empty layers filled with set_layer().
+            texture_2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap);
+            // One layer per file. Files that don't match the size of the first one leave their layer empty.
+            texture_2d_array(const std::vector<std::filesystem::path>& paths, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip = true);
+            virtual ~texture_2d_array();
+
+            virtual void bind(uint32_t slot = 0) const override;
+            [[maybe_unused]] virtual void unbind() const override;
+
+            [[maybe_unused]] virtual uint32_t id() const override { return m_id; }
+            [[maybe_unused]] virtual int32_t width() const override { return m_width; }
+            [[maybe_unused]] virtual int32_t height() const override { return m_height; }
+            [[maybe_unused]] virtual int32_t channels() const override { return m_channels; }
+            [[maybe_unused]] virtual uint8_t* data() const override { return nullptr; }
+            virtual bool ready() const override { return true; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override { set_layer(0, x, y, width, height, pixels); }
+            virtual uint32_t layers() const override { return m_layers; }
+            virtual void set_layer(uint32_t layer, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override;
+            [[nodiscard]] inline uint64_t memory() const { return m_memory; }
+            [[nodiscard]] inline int32_t levels() const { return m_levels; }
+
+        private:
+            void storage();
+
+            int32_t m_width{0};
+            int32_t m_height{0};
+            int32_t m_channels{0};
+            uint32_t m_layers{0};
+            uint32_t m_id{0};
+            TEXTURE_TYPE m_type{TEXTURE_2D_ARRAY};
+            TEXTURE_FILTER m_filter{TEX_FILTER_LINEAR};
+            int32_t m_levels{1};
+            uint64_t m_memory{0};
+    };
+
+    // Single level texture with a render target format, backing framebuffer attachments.
+    class render_texture final : public gapi::texture {
+
+        public:
+            render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height);
+            virtual ~render_texture();
+
+            virtual void bind(uint32_t slot = 0) const override;
+            [[maybe_unused]] virtual void unbind() const override;
+
+            [[maybe_unused]] virtual uint32_t id() const override { return m_id; }
+            [[maybe_unused]] virtual int32_t width() const override { return m_width; }
+            [[maybe_unused]] virtual int32_t height() const override { return m_height; }
+            [[maybe_unused]] virtual int32_t channels() const override { return depth_format(m_format) ? 1 : 4; }
+            [[maybe_unused]] virtual uint8_t* data() const override { return nullptr; }
+            virtual bool ready() const override { return true; }
+            virtual void set_data(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* pixels) override;
+            [[nodiscard]] inline ATTACHMENT_FORMAT format() const { return m_format; }
+
+        private:
+            int32_t m_width{0};
+            int32_t m_height{0};
+            uint32_t m_id{0};
+            ATTACHMENT_FORMAT m_format{ATTACHMENT_NONE};
+    };
+
+    class framebuffer final : public gapi::framebuffer {
+
+        public:
+            // Without a factory every attachment is a new render_texture.
+            framebuffer(const framebuffer_spec& spec, attachment_factory factory = nullptr);
+            framebuffer(const framebuffer&) = delete;
+            framebuffer& operator=(const framebuffer&) = delete;
+            virtual ~framebuffer();
+
+            virtual void bind() const override;
+            virtual void unbind() const override;
+            virtual void resize(int32_t width, int32_t height) override;
+
+            [[maybe_unused]] virtual uint32_t id() const override { return m_id; }
+            virtual const framebuffer_spec& spec() const override { return m_spec; }
+            virtual const std::shared_ptr<gapi::texture>& color(uint32_t index = 0) const override { return m_colors[index]; }
+            virtual const std::shared_ptr<gapi::texture>& depth() const override { return m_depth; }
+
+        private:
+            void attach();
+
+        private:
+            uint32_t m_id{0};
+            framebuffer_spec m_spec{};
+            attachment_factory m_factory{};
+            std::vector<std::shared_ptr<gapi::texture>> m_colors{};
+            std::shared_ptr<gapi::texture> m_depth{nullptr};
+    };
+
+    // Decodes image files on a pool of worker threads and streams the pixels to the GPU through a
+    // pixel unpack buffer, at most upload_budget bytes per update(). load() returns at once with a
+    // texture that binds a checkerboard placeholder until its last row has been uploaded. Without
+    // keep_data its textures drop their decoded copy once uploaded, as with the texture_2d constructor.
+    class texture_loader{
+
+        public:
+            texture_loader(uint32_t workers, uint32_t upload_budget, bool keep_data = true);
+            texture_loader(const texture_loader&) = delete;
+            texture_loader& operator=(const texture_loader&) = delete;
+            ~texture_loader();
+
+            [[nodiscard]] std::shared_ptr<texture_2d> load(const std::filesystem::path& path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip = true);
+            // Streams the file of an existing texture into it again. It shows its current contents until
+            // the new ones start uploading, then the placeholder; a failed load keeps the placeholder.
+            void reload(const std::shared_ptr<texture_2d>& texture);
+            // GL thread, once per frame. Textures dropped by their owner before completion are skipped.
+            void update();
+            [[nodiscard]] uint32_t pending() const { return m_pending; }
+
+        private:
+            struct job{
+                std::weak_ptr<texture_2d> texture{};
+                std::filesystem::path path{};
+                bool flip{true};
+                uint8_t* pixels{nullptr};
+                int32_t width{0};
+                int32_t height{0};
+                int32_t channels{0};
+                int32_t uploaded_rows{0};
+                std::shared_ptr<compressed_image> compressed{nullptr};
+            };
+
+            void work();
+            void vacate(texture_2d& texture);
+
+        private:
+            std::shared_ptr<const texture_2d> m_placeholder{nullptr};
+            uint32_t m_pbo{0};
+            uint32_t m_pbo_size{0};
+            uint32_t m_upload_budget{0};
+            uint32_t m_pending{0};
+            bool m_keep_data{true};
+
+            std::deque<job> m_requests{};
+            std::deque<job> m_decoded{};
+            std::deque<job> m_uploads{};
+            std::mutex m_mutex{};
+            std::condition_variable m_wake{};
+            bool m_stop{false};
+            std::vector<std::thread> m_workers{};
+    };
+
+    struct texture_residency_stats{
+        uint32_t tracked{0};
+        uint32_t resident{0};
+        uint32_t evicted{0};
+        uint32_t evictions{0};
+        uint32_t reloads{0};
+        uint64_t cpu_bytes{0};
+        uint64_t gpu_bytes{0};
+        uint64_t budget{0};
+
+        [[nodiscard]] inline uint64_t bytes() const { return cpu_bytes + gpu_bytes; }
+    };
+
+    // Keeps the CPU and GPU memory of the textures it tracks under a budget. update() evicts the
+    // least recently bound file backed textures until the total fits; an evicted texture frees
+    // both copies and binds a placeholder. Binding it again brings it back on the next update(),
+    // streamed through the loader when one is given, otherwise loaded on the spot. Textures bound
+    // since the previous update() are never evicted, so a frame's working set can't thrash.
+    class texture_residency{
+
+        public:
+            texture_residency(uint64_t budget, std::shared_ptr<texture_loader> loader = nullptr);
+            texture_residency(const texture_residency&) = delete;
+            texture_residency& operator=(const texture_residency&) = delete;
+
+            void track(const std::shared_ptr<texture_2d>& texture);
+            // GL thread, once per frame.
+            void update();
+
+            void budget(uint64_t bytes) { m_budget = bytes; }
+            [[nodiscard]] inline uint64_t budget() const { return m_budget; }
+            [[nodiscard]] texture_residency_stats stats() const;
+
+        private:
+            struct entry{
+                std::weak_ptr<texture_2d> texture{};
+                bool evicted{false};
+                uint64_t evicted_at{0};
+            };
+
+        private:
+            uint64_t m_budget{0};
+            std::shared_ptr<texture_loader> m_loader{nullptr};
+            std::shared_ptr<const texture_2d> m_placeholder{nullptr};
+            std::vector<entry> m_entries{};
+            uint64_t m_frame_clock{0};
+            uint32_t m_evictions{0};
+            uint32_t m_reloads{0};
+            bool m_over_budget{false};
+    };
+
+    // Tightly packed RGBA8, top row first.
+    struct readback_image{
+        int32_t width{0};
+        int32_t height{0};
+        uint64_t sequence{0};
+        std::vector<uint8_t> pixels{};
+    };
+
+    // GL thread.
+    using readback_callback = std::function<void(readback_image image)>;
+
+    struct readback_stats{
+        uint32_t reads{0};
+        uint32_t delivered{0};
+        // Reads that had to wait for the GPU because every pack buffer was still in flight.
+        uint32_t stalls{0};
+        uint32_t encoded{0};
+        uint32_t failed{0};
+    };
+
+    // Reads pixels back without stalling the pipeline. read() only records a copy into the next
+    // of a ring of pixel pack buffers and fences it; update() delivers every copy the GPU has
+    // finished, oldest first, usually a frame or two later. With all buffers in flight, read()
+    // waits for the oldest one instead of dropping a frame, so continuous capture stays complete.
+    //
+    // png() returns a callback that hands the image to the encoder threads, which write it with
+    // stb_image_write. Copies still in flight at destruction are dropped, queued encodes finish.
+    class readback{
+
+        public:
+            readback(uint32_t buffers, uint32_t workers);
+            readback(const readback&) = delete;
+            readback& operator=(const readback&) = delete;
+            ~readback();
+
+            // A 2D color texture, texture_2d or a framebuffer attachment.
+            void read(const gapi::texture& source, readback_callback callback);
+            void read(const gapi::framebuffer& source, readback_callback callback, uint32_t attachment = 0);
+            // The window's back buffer, leaves the default framebuffer bound.
+            void read_window(readback_callback callback);
+            // GL thread, once per frame.
+            void update();
+
+            [[nodiscard]] readback_callback png(std::filesystem::path path);
+            [[nodiscard]] readback_stats stats() const;
+
+        private:
+            struct slot{
+                uint32_t pbo{0};
+                uint32_t size{0};
+                GLsync fence{nullptr};
+                int32_t width{0};
+                int32_t height{0};
+                uint64_t sequence{0};
+                readback_callback callback{};
+            };
+
+            struct encode{
+                std::filesystem::path path{};
+                readback_image image{};
+            };
+
+            slot& acquire(int32_t width, int32_t height, readback_callback callback);
+            void deliver(slot& target);
+            void work();
+
+        private:
+            std::vector<slot> m_slots{};
+            uint32_t m_next{0};
+            uint64_t m_sequence{0};
+            readback_stats m_stats{};
+
+            std::deque<encode> m_encodes{};
+            mutable std::mutex m_mutex{};
+            std::condition_variable m_wake{};
+            bool m_stop{false};
+            std::vector<std::thread> m_workers{};
+    };
+
+    struct gpu_zone_stats{
+        std::string name{};
+        uint32_t depth{0};
+        // Sum over the zone's scopes in the latest frame whose results came back.
+        double gpu_ms{0.0};
+        double cpu_ms{0.0};
+        double gpu_average_ms{0.0};
+        double cpu_average_ms{0.0};
+        uint64_t frames{0};
+    };
+
+    // Times named zones on the GPU with a pair of GL_TIMESTAMP queries each, so zones can nest,
+    // and on the CPU with the steady clock. Each frame gets its own set of query objects from a
+    // ring of latency frames; begin_frame() collects every earlier frame whose queries have
+    // completed, without waiting, so results arrive a few frames late. A frame still unfinished
+    // when its set comes round again is dropped rather than waited for.
+    //
+    // The whole frame is a zone itself, zones opened inside it are one level deeper. Results are
+    // aggregated per zone name, in the order the names first appeared.
+    class gpu_profiler{
+
+        public:
+            static constexpr double average_weight = 0.05;
+
+            explicit gpu_profiler(uint32_t latency);
+            gpu_profiler(const gpu_profiler&) = delete;
+            gpu_profiler& operator=(const gpu_profiler&) = delete;
+            ~gpu_profiler();
+
+            // GL thread. gpu_zone scopes report to the profiler between these two calls.
+            void begin_frame(std::string_view name = "frame");
+            void end_frame();
+            void begin(std::string_view name);
+            void end();
+
+            [[nodiscard]] const std::vector<gpu_zone_stats>& zones() const { return m_zones; }
+            [[nodiscard]] uint32_t dropped() const { return m_dropped; }
+            [[nodiscard]] static gpu_profiler* current() { return s_current; }
+
+        private:
+            struct record{
+                uint32_t zone{0};
+                uint32_t begin_query{0};
+                uint32_t end_query{0};
+                std::chrono::steady_clock::time_point cpu_begin{};
+                double cpu_ms{0.0};
+            };
+
+            struct frame{
+                std::vector<uint32_t> queries{};
+                uint32_t used{0};
+                std::vector<record> records{};
+                bool pending{false};
+            };
+
+            uint32_t query(frame& target);
+            uint32_t zone(std::string_view name, uint32_t depth);
+            bool collect(frame& target);
+
+        private:
+            std::vector<frame> m_frames{};
+            uint32_t m_index{0};
+            bool m_recording{false};
+            std::vector<uint32_t> m_open{};
+            std::vector<gpu_zone_stats> m_zones{};
+            std::unordered_map<std::string, uint32_t> m_lookup{};
+            std::vector<double> m_frame_gpu{};
+            std::vector<double> m_frame_cpu{};
+            uint32_t m_dropped{0};
+
+            inline static gpu_profiler* s_current{nullptr};
+    };
+
+    // Times the enclosing scope on the profiler of the current frame, does nothing without one.
+    class gpu_zone{
+
+        public:
+            explicit gpu_zone(std::string_view name) : m_profiler(gpu_profiler::current()){
+                if(m_profiler != nullptr) m_profiler->begin(name);
+            }
+            gpu_zone(const gpu_zone&) = delete;
+            gpu_zone& operator=(const gpu_zone&) = delete;
+            ~gpu_zone(){
+                if(m_profiler != nullptr) m_profiler->end();
+            }
+
+        private:
+            gpu_profiler* m_profiler{nullptr};
     };
 
     class api final : public gapi::base_api {
@@ -232,18 +917,48 @@ namespace gapi::opengl{
 
             virtual void init() override;
             virtual void draw(const std::shared_ptr<gapi::vertex_array>& va) override;
+            virtual void draw(const gapi::vertex_array& va, uint32_t count) override;
+            virtual void draw(const gapi::vertex_array& va, uint32_t count, uint32_t base_vertex) override;
+            virtual void draw_instanced(const gapi::vertex_array& va, uint32_t instance_count) override;
+            virtual void draw_indirect(const gapi::vertex_array& va, const gapi::indirect_buffer& commands, uint32_t first, uint32_t draw_count) override;
+            virtual void draw(const gapi::vertex_array& va, const draw_indirect_command& command) override;
             virtual void clear() override;
             virtual void clear_color(float r, float g, float b, float a) override;
+            virtual void unbind_texture(uint32_t slot) override;
+            virtual uint32_t max_texture_slots() const override { return m_max_texture_slots; }
+            virtual bool draw_parameters() const override { return m_draw_parameters; }
             virtual GAPI xapi() const override { return gapi::GAPI::OPENGL; }
+
+        private:
+            uint32_t m_max_texture_slots{0};
+            bool m_draw_parameters{false};
     };
 
     [[nodiscard]] std::shared_ptr<context> make_context(GLFWwindow* window) noexcept;
     [[nodiscard]] std::shared_ptr<vertex_buffer> make_vertex(float* v, uint32_t s, DRAW t) noexcept;
+    [[nodiscard]] std::shared_ptr<vertex_buffer> make_vertex(uint32_t s, DRAW t) noexcept;
+    [[nodiscard]] std::shared_ptr<stream_buffer> make_stream(uint32_t frame_size, uint32_t frames = 3) noexcept;
+    // Picks 16-bit storage when every index fits, see gapi::index_type_for.
     [[nodiscard]] std::shared_ptr<index_buffer> make_index(uint32_t* i, size_t c, DRAW t) noexcept;
+    [[nodiscard]] std::shared_ptr<index_buffer> make_index(uint16_t* i, size_t c, DRAW t) noexcept;
+    [[nodiscard]] std::shared_ptr<uniform_buffer> make_uniform(uint32_t s, uint32_t binding, DRAW t = DRAW_DYNAMIC) noexcept;
+    [[nodiscard]] std::shared_ptr<indirect_buffer> make_indirect() noexcept;
+    [[nodiscard]] std::shared_ptr<storage_buffer> make_storage(uint32_t s, uint32_t binding) noexcept;
     [[nodiscard]] std::shared_ptr<vertex_array> make_array() noexcept;
-    [[nodiscard]] std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip = true) noexcept;
-    [[nodiscard]] std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& path) noexcept;
-    [[nodiscard]] std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d> make_texture2d(std::filesystem::path path, TEXTURE_FILTER filter, TEXTURE_WRAP wrap,  bool flip = true, bool keep_data = true) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d> make_texture2d(int32_t width, int32_t height, int32_t channels, const uint8_t* pixels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d_array> make_texture2d_array(int32_t width, int32_t height, uint32_t layers, int32_t channels, TEXTURE_FILTER filter, TEXTURE_WRAP wrap) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_2d_array> make_texture2d_array(const std::vector<std::filesystem::path>& paths, TEXTURE_FILTER filter, TEXTURE_WRAP wrap, bool flip = true) noexcept;
+    [[nodiscard]] std::shared_ptr<render_texture> make_render_texture(ATTACHMENT_FORMAT format, int32_t width, int32_t height) noexcept;
+    [[nodiscard]] std::shared_ptr<framebuffer> make_framebuffer(const framebuffer_spec& spec, attachment_factory factory = nullptr) noexcept;
+    // workers = 0 picks one per spare hardware thread, up to four.
+    [[nodiscard]] std::shared_ptr<texture_loader> make_texture_loader(uint32_t workers = 0, uint32_t upload_budget = 4 * 1024 * 1024, bool keep_data = true) noexcept;
+    [[nodiscard]] std::shared_ptr<texture_residency> make_texture_residency(uint64_t budget, std::shared_ptr<texture_loader> loader = nullptr) noexcept;
+    [[nodiscard]] std::shared_ptr<readback> make_readback(uint32_t buffers = 3, uint32_t workers = 1) noexcept;
+    [[nodiscard]] std::shared_ptr<gpu_profiler> make_gpu_profiler(uint32_t latency = 4) noexcept;
+    [[nodiscard]] std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& path, const shader_defines& defines = {}) noexcept;
+    [[nodiscard]] std::shared_ptr<shader> make_shader(const std::string& sname, const std::filesystem::path& vertex, const std::filesystem::path& fragment, const shader_defines& defines = {}) noexcept;
+    [[nodiscard]] gapi::shader_factory make_shader_factory() noexcept;
     
 }
 
@@ -0,0 +1,100 @@
+#include "gapi_render_queue.hpp"
+
+namespace gapi::renderer{
+
+    static inline uint64_t mask(uint32_t value, uint32_t bits){
+        return static_cast<uint64_t>(value) & ((uint64_t{1} << bits) - 1);
+    }
+
+    uint64_t sort_key::make(uint32_t pass, bool translucent, uint32_t shader, uint32_t texture, uint32_t vao, float depth){
+        constexpr float depth_max = static_cast<float>((1u << depth_bits) - 1);
+        uint32_t quantized = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * depth_max);
+
+        uint64_t state = mask(shader, shader_bits) << (texture_bits + vao_bits)
+                       | mask(texture, texture_bits) << vao_bits
+                       | mask(vao, vao_bits);
+
+        uint64_t key = mask(pass, pass_bits) << (64 - pass_bits)
+                     | mask(translucent ? 1 : 0, translucent_bits) << (64 - pass_bits - translucent_bits);
+
+        if(translucent){
+            uint32_t far_first = static_cast<uint32_t>(depth_max) - quantized;
+            return key | mask(far_first, depth_bits) << (shader_bits + texture_bits + vao_bits) | state;
+        }
+
+        return key | state << depth_bits | mask(quantized, depth_bits);
+    }
+
+    void render_queue::clear(){
+        m_commands.clear();
+        m_order.clear();
+        m_views = 1;
+        m_stats = {};
+    }
+
+    void render_queue::push(const render_command& command){
+        m_stats.submitted_state_changes += state_changes(m_commands.empty() ? render_command{} : m_commands.back(), command);
+
+        m_order.push_back({command.key, static_cast<uint32_t>(m_commands.size())});
+        m_commands.push_back(command);
+        m_views = std::max(m_views, command.view + 1);
+        m_stats.commands++;
+    }
+
+    // LSD radix sort, one byte per pass. Passes where every key shares the same
+    // byte are skipped, so short frames with few distinct states stay cheap.
+    void render_queue::sort(){
+        const size_t count = m_order.size();
+        if(count == 0) return;
+
+        m_scratch.resize(count);
+        for(uint32_t shift = 0; shift < 64; shift += 8){
+            uint32_t histogram[256]{};
+            for(const auto& entry : m_order)
+                histogram[(entry.key >> shift) & 0xFF]++;
+
+            if(histogram[(m_order[0].key >> shift) & 0xFF] == count) continue;
+
+            uint32_t offset = 0;
+            for(auto& bucket : histogram){
+                uint32_t c = bucket;
+                bucket = offset;
+                offset += c;
+            }
+
+            for(const auto& entry : m_order)
+                m_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+
+            m_order.swap(m_scratch);
+        }
+
+        // One more stable counting pass makes the view the most significant order
+        if(m_views > 1){
+            m_view_offsets.assign(m_views, 0);
+            for(const auto& entry : m_order)
+                m_view_offsets[m_commands[entry.index].view]++;
+
+            uint32_t offset = 0;
+            for(auto& bucket : m_view_offsets){
+                uint32_t c = bucket;
+                bucket = offset;
+                offset += c;
+            }
+
+            for(const auto& entry : m_order)
+                m_scratch[m_view_offsets[m_commands[entry.index].view]++] = entry;
+
+            m_order.swap(m_scratch);
+        }
+
+        m_stats.executed_state_changes = state_changes(render_command{}, m_commands[m_order[0].index]);
+        for(size_t i = 1; i < count; i++)
+            m_stats.executed_state_changes += state_changes(m_commands[m_order[i - 1].index], m_commands[m_order[i].index]);
+    }
+
+    uint32_t render_queue::state_changes(const render_command& previous, const render_command& current){
+        return (previous.shader != current.shader ? 1 : 0)
+             + (previous.texture != current.texture ? 1 : 0)
+             + (previous.va != current.va ? 1 : 0);
+    }
+}
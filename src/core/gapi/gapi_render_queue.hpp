@@ -0,0 +1,76 @@
+#pragma once
+
+#include "gapi.hpp"
+
+namespace gapi::renderer{
+
+    // 64-bit sort key, most significant field first:
+    //   opaque      : pass(4) | translucent(1) | shader(11) | texture(16) | vao(16) | depth(16)
+    //   translucent : pass(4) | translucent(1) | depth(16, far first) | shader(11) | texture(16) | vao(16)
+    // Translucent commands keep depth ahead of state so they still blend back-to-front.
+    struct sort_key{
+        static constexpr uint32_t pass_bits        = 4;
+        static constexpr uint32_t translucent_bits = 1;
+        static constexpr uint32_t shader_bits      = 11;
+        static constexpr uint32_t texture_bits     = 16;
+        static constexpr uint32_t vao_bits         = 16;
+        static constexpr uint32_t depth_bits       = 16;
+
+        [[nodiscard]] static uint64_t make(uint32_t pass, bool translucent, uint32_t shader, uint32_t texture, uint32_t vao, float depth);
+    };
+
+    // Commands keep raw pointers; every resource submitted must stay alive until end_frame.
+    // view orders ahead of the key: all commands of a view are drawn before the next view's.
+    struct render_command{
+        uint64_t key{0};
+        uint32_t view{0};
+        gapi::shader* shader{nullptr};
+        gapi::texture* texture{nullptr};
+        gapi::vertex_array* va{nullptr};
+        uint32_t count{0};
+        uint32_t instances{1};
+    };
+
+    struct render_queue_stats{
+        uint32_t commands{0};
+        uint32_t submitted_state_changes{0};
+        uint32_t executed_state_changes{0};
+
+        [[nodiscard]] inline uint32_t avoided_state_changes() const {
+            return submitted_state_changes > executed_state_changes ? submitted_state_changes - executed_state_changes : 0;
+        }
+    };
+
+    class render_queue{
+
+        public:
+            render_queue() = default;
+            render_queue(const render_queue&) = delete;
+            render_queue& operator=(const render_queue&) = delete;
+            ~render_queue() = default;
+
+            void clear();
+            void push(const render_command& command);
+            void sort();
+
+            [[nodiscard]] inline const render_queue_stats& stats() const { return m_stats; }
+            [[nodiscard]] inline size_t size() const { return m_order.size(); }
+            [[nodiscard]] inline const render_command& operator[](size_t i) const { return m_commands[m_order[i].index]; }
+
+        private:
+            struct sort_entry{
+                uint64_t key{0};
+                uint32_t index{0};
+            };
+
+            static uint32_t state_changes(const render_command& previous, const render_command& current);
+
+        private:
+            std::vector<render_command> m_commands{};
+            std::vector<sort_entry> m_order{};
+            std::vector<sort_entry> m_scratch{};
+            std::vector<uint32_t> m_view_offsets{};
+            uint32_t m_views{1};
+            render_queue_stats m_stats{};
+    };
+}
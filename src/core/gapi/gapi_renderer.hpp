@@ -1,9 +1,131 @@
 #pragma once
 
 #include "gapi_impl_opengl.hpp"
+#include "gapi_impl_null.hpp"
+#include "gapi_render_queue.hpp"
 
 namespace gapi::renderer{
 
+    // Shared by every shader that declares `layout(std140) uniform per_frame`.
+    enum PER_FRAME : size_t{
+        PER_FRAME_PROJECTION_VIEW   = 0,
+        PER_FRAME_TIME              = 1
+    };
+
+    using per_frame_layout = std140_layout<STD140_MAT4, STD140_FLOAT>;
+
+    // One std430 record per indirect draw, read in the shader as per_draw[u_draw_base + gl_DrawID].
+    // Without ARB_shader_draw_parameters gl_DrawID reads as 0 and every draw sets u_draw_base itself.
+    struct per_draw{
+        glm::mat4 model{1.0f};
+        glm::vec4 color{1.0f};
+    };
+
+    template<typename GApi>
+    struct gapi_factory;
+
+    template<>
+    struct gapi_factory<ggl::api>{
+
+        // Scoped GPU timing zone for passes.
+        using zone = ggl::gpu_zone;
+
+        static std::shared_ptr<gapi::vertex_buffer> dynamic_vertex(uint32_t size){
+            return ggl::make_vertex(size, ggl::DRAW_DYNAMIC);
+        }
+
+        static std::shared_ptr<gapi::stream_buffer> stream_vertex(uint32_t frame_size, uint32_t frames){
+            return ggl::make_stream(frame_size, frames);
+        }
+
+        static std::shared_ptr<gapi::index_buffer> static_index(uint32_t* indices, size_t count){
+            return ggl::make_index(indices, count, ggl::DRAW_STATIC);
+        }
+
+        static std::shared_ptr<gapi::uniform_buffer> uniform(uint32_t size, uint32_t binding){
+            return ggl::make_uniform(size, binding, ggl::DRAW_DYNAMIC);
+        }
+
+        static std::shared_ptr<gapi::indirect_buffer> indirect(){
+            return ggl::make_indirect();
+        }
+
+        static std::shared_ptr<gapi::storage_buffer> storage(uint32_t size, uint32_t binding){
+            return ggl::make_storage(size, binding);
+        }
+
+        static std::shared_ptr<gapi::vertex_array> array(){
+            return ggl::make_array();
+        }
+
+        static std::shared_ptr<gapi::texture> texture(int32_t width, int32_t height, int32_t channels){
+            return ggl::make_texture2d(width, height, channels, nullptr, ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
+        }
+
+        static std::shared_ptr<gapi::texture_array> texture_array(int32_t width, int32_t height, uint32_t layers, int32_t channels){
+            return ggl::make_texture2d_array(width, height, layers, channels, ggl::TEX_FILTER_LINEAR, ggl::TEX_WRAP_CLAMP);
+        }
+
+        static std::shared_ptr<gapi::framebuffer> framebuffer(const framebuffer_spec& spec, attachment_factory attachments = nullptr){
+            return ggl::make_framebuffer(spec, std::move(attachments));
+        }
+
+        static std::shared_ptr<gapi::texture> attachment(ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+            return ggl::make_render_texture(format, width, height);
+        }
+    };
+
+    template<>
+    struct gapi_factory<gnull::api>{
+
+        // Scoped GPU timing zone for passes.
+        using zone = gnull::gpu_zone;
+
+        static std::shared_ptr<gapi::vertex_buffer> dynamic_vertex(uint32_t size){
+            return gnull::make_vertex(size);
+        }
+
+        static std::shared_ptr<gapi::stream_buffer> stream_vertex(uint32_t frame_size, uint32_t frames){
+            return gnull::make_stream(frame_size, frames);
+        }
+
+        static std::shared_ptr<gapi::index_buffer> static_index(uint32_t* indices, size_t count){
+            return gnull::make_index(indices, count);
+        }
+
+        static std::shared_ptr<gapi::uniform_buffer> uniform(uint32_t size, uint32_t binding){
+            return gnull::make_uniform(size, binding);
+        }
+
+        static std::shared_ptr<gapi::indirect_buffer> indirect(){
+            return gnull::make_indirect();
+        }
+
+        static std::shared_ptr<gapi::storage_buffer> storage(uint32_t size, uint32_t binding){
+            return gnull::make_storage(size, binding);
+        }
+
+        static std::shared_ptr<gapi::vertex_array> array(){
+            return gnull::make_array();
+        }
+
+        static std::shared_ptr<gapi::texture> texture(int32_t width, int32_t height, int32_t channels){
+            return gnull::make_texture2d(width, height, channels);
+        }
+
+        static std::shared_ptr<gapi::texture_array> texture_array(int32_t width, int32_t height, uint32_t layers, int32_t channels){
+            return gnull::make_texture2d_array(width, height, layers, channels);
+        }
+
+        static std::shared_ptr<gapi::framebuffer> framebuffer(const framebuffer_spec& spec, attachment_factory attachments = nullptr){
+            return gnull::make_framebuffer(spec, std::move(attachments));
+        }
+
+        static std::shared_ptr<gapi::texture> attachment(ATTACHMENT_FORMAT format, int32_t width, int32_t height){
+            return gnull::make_render_texture(format, width, height);
+        }
+    };
+
     template<typename GApi>
     class gapi_render {
 
@@ -16,6 +138,10 @@ namespace gapi::renderer{
             void init(){
                 api = std::make_shared<GApi>();
                 api->init();
+                m_per_frame = gapi_factory<GApi>::uniform(per_frame_layout::size, UNIFORM_BINDING_PER_FRAME);
+                m_indirect_buffer = gapi_factory<GApi>::indirect();
+                m_per_draw = gapi_factory<GApi>::storage(sizeof(per_draw) * 1024, STORAGE_BINDING_PER_DRAW);
+                camera(glm::mat4(1.0f));
             }
 
             void clear(){
@@ -26,22 +152,227 @@ namespace gapi::renderer{
                 api->clear_color(r, g, b, a);
             }
 
-            void submit(const std::shared_ptr<vertex_array>& va){
+            void begin_frame(const glm::mat4& projection_view = glm::mat4(1.0f), float time = 0.0f){
+                m_queue.clear();
+                m_indirect.clear();
+                m_retained.clear();
+                m_views.clear();
+                m_frame.template set<PER_FRAME_TIME>(time);
+                camera(projection_view);
+            }
+
+            // Queued commands are drawn with the camera that was current when they were submitted,
+            // each camera being a view of its own. The per-frame block is updated right away as well
+            // for draws that bypass the queue.
+            void camera(const glm::mat4& projection_view){
+                if(m_views.empty() || m_view_submitted) m_views.push_back(projection_view);
+                else m_views.back() = projection_view;
+                m_view_submitted = false;
+                use_view(static_cast<uint32_t>(m_views.size() - 1));
+            }
+
+            void submit(const std::shared_ptr<shader>& shader, const std::shared_ptr<vertex_array>& va,
+                const std::shared_ptr<texture>& texture = nullptr, float depth = 0.0f, uint32_t pass = 0, bool translucent = false){
+                m_queue.push(command(shader, va, texture, depth, pass, translucent));
+            }
+
+            // One command for every instance; per-instance data comes from STEP_INSTANCE elements of va.
+            void submit_instanced(const std::shared_ptr<shader>& shader, const std::shared_ptr<vertex_array>& va, uint32_t instances,
+                const std::shared_ptr<texture>& texture = nullptr, float depth = 0.0f, uint32_t pass = 0){
+                if(instances == 0) return;
+                render_command instanced = command(shader, va, texture, depth, pass, false);
+                instanced.instances = instances;
+                m_queue.push(instanced);
+            }
+
+            // Static geometry: draws sharing a shader and vertex array are merged into one
+            // glMultiDrawElementsIndirect call at end_frame, ahead of the sorted queue.
+            void submit_indirect(const std::shared_ptr<shader>& shader, const std::shared_ptr<vertex_array>& va,
+                const per_draw& data, const draw_indirect_command& draw){
+                retain(shader);
+                retain(va);
+                m_indirect.push_back({static_cast<uint64_t>(shader->id()) << 32 | va->id(), submit_view(), shader.get(), va.get(), draw, data});
+            }
+
+            void submit_indirect(const std::shared_ptr<shader>& shader, const std::shared_ptr<vertex_array>& va, const per_draw& data){
+                submit_indirect(shader, va, data, {va->index()->count(), 1, 0, 0, 0});
+            }
+
+            void end_frame(){
+                TRIMANA_PROFILE_SCOPE("gapi_render::end_frame");
+                typename gapi_factory<GApi>::zone zone("render queue");
+                flush_indirect();
+                m_queue.sort();
+
+                const gapi::shader* shader{nullptr};
+                const gapi::texture* texture{nullptr};
+                const gapi::vertex_array* va{nullptr};
+                // Whatever the frame left on slot 0 counts as unknown until the first command sets it
+                bool texture_known = false;
+                for(size_t i = 0; i < m_queue.size(); i++){
+                    const render_command& command = m_queue[i];
+                    if(command.view != m_bound_view) use_view(command.view);
+                    if(command.shader != shader){
+                        command.shader->bind();
+                        shader = command.shader;
+                    }
+                    if(command.texture != texture || !texture_known){
+                        if(command.texture != nullptr) command.texture->bind();
+                        else api->unbind_texture(0);
+                        texture = command.texture;
+                        texture_known = true;
+                    }
+                    if(command.va != va){
+                        command.va->bind();
+                        va = command.va;
+                    }
+                    if(command.instances > 1) api->draw_instanced(*command.va, command.instances);
+                    else api->draw(*command.va, command.count);
+                }
+
+                // Draws after the queue see the latest camera again
+                if(m_bound_view + 1 != m_views.size()) use_view(static_cast<uint32_t>(m_views.size() - 1));
+                m_retained.clear();
+            }
+
+            // Draws issued afterwards, end_frame included, go to target until it is unbound.
+            // Targets nest: unbind_target() returns to the previous one or to the window.
+            void bind_target(const std::shared_ptr<framebuffer>& target){
+                m_targets.push_back(target);
+                target->bind();
+            }
+
+            void unbind_target(){
+                if(m_targets.empty()) return;
+                m_targets.back()->unbind();
+                m_targets.pop_back();
+                if(!m_targets.empty()) m_targets.back()->bind();
+            }
+
+            // Bypasses the queue for streaming geometry whose buffers are rewritten within the frame.
+            void draw_immediate(const std::shared_ptr<vertex_array>& va, uint32_t count, uint32_t base_vertex = 0){
+                va->bind();
+                if(base_vertex == 0) api->draw(*va, count);
+                else api->draw(*va, count, base_vertex);
+            }
+
+            void draw_instanced(const std::shared_ptr<vertex_array>& va, uint32_t instance_count){
                 va->bind();
-                draw(va);
+                api->draw_instanced(*va, instance_count);
             }
-    
+
+            [[nodiscard]] uint32_t max_texture_slots() const { return api->max_texture_slots(); }
+            [[nodiscard]] const render_queue_stats& queue_stats() const { return m_queue.stats(); }
+
         private:
-            void draw(const std::shared_ptr<vertex_array>& va){
-                api->draw(va);
+            struct indirect_draw{
+                uint64_t key{0};
+                uint32_t view{0};
+                gapi::shader* shader{nullptr};
+                gapi::vertex_array* va{nullptr};
+                draw_indirect_command draw{};
+                per_draw data{};
+            };
+
+            void flush_indirect(){
+                if(m_indirect.empty()) return;
+                TRIMANA_PROFILE_SCOPE("gapi_render::flush_indirect");
+
+                std::stable_sort(m_indirect.begin(), m_indirect.end(),
+                    [](const indirect_draw& a, const indirect_draw& b){ return a.view != b.view ? a.view < b.view : a.key < b.key; });
+
+                m_indirect_commands.clear();
+                m_indirect_data.clear();
+                for(const auto& entry : m_indirect){
+                    m_indirect_commands.push_back(entry.draw);
+                    m_indirect_data.push_back(entry.data);
+                }
+
+                const bool multi_draw = api->draw_parameters();
+                if(multi_draw) m_indirect_buffer->set_data(m_indirect_commands);
+                m_per_draw->set_data(m_indirect_data.data(), static_cast<uint32_t>(m_indirect_data.size() * sizeof(per_draw)));
+                m_per_draw->bind();
+
+                const uint32_t count = static_cast<uint32_t>(m_indirect.size());
+                for(uint32_t first = 0; first < count;){
+                    uint32_t last = first + 1;
+                    while(last < count && m_indirect[last].key == m_indirect[first].key && m_indirect[last].view == m_indirect[first].view) last++;
+
+                    const indirect_draw& group = m_indirect[first];
+                    if(group.view != m_bound_view) use_view(group.view);
+                    group.shader->bind();
+                    group.va->bind();
+                    if(multi_draw){
+                        group.shader->uniform("u_draw_base"_uniform, static_cast<uint32_t>(first));
+                        api->draw_indirect(*group.va, *m_indirect_buffer, first, last - first);
+                    }
+                    else{
+                        for(uint32_t i = first; i < last; i++){
+                            group.shader->uniform("u_draw_base"_uniform, i);
+                            api->draw(*group.va, m_indirect[i].draw);
+                        }
+                    }
+                    first = last;
+                }
+                m_indirect.clear();
+            }
+
+            // Raw pointers sort and compare cheaply; the frame holds the owning references.
+            render_command command(const std::shared_ptr<shader>& shader, const std::shared_ptr<vertex_array>& va,
+                const std::shared_ptr<texture>& texture, float depth, uint32_t pass, bool translucent){
+                retain(shader);
+                retain(va);
+                retain(texture);
+                render_command command{};
+                command.view    = submit_view();
+                command.shader  = shader.get();
+                command.texture = texture.get();
+                command.va      = va.get();
+                command.count   = va->index()->count();
+                command.key     = sort_key::make(pass, translucent, shader->id(), texture ? texture->id() : 0, va->id(), depth);
+                return command;
+            }
+
+            void retain(std::shared_ptr<const void> resource){
+                if(resource != nullptr) m_retained.push_back(std::move(resource));
+            }
+
+            // The current camera becomes fixed once a command uses it.
+            uint32_t submit_view(){
+                m_view_submitted = true;
+                return static_cast<uint32_t>(m_views.size() - 1);
+            }
+
+            void use_view(uint32_t view){
+                m_frame.template set<PER_FRAME_PROJECTION_VIEW>(m_views[view]);
+                m_per_frame->set_data(m_frame);
+                m_bound_view = view;
             }
 
         private:
             std::shared_ptr<GApi> api;
+            render_queue m_queue{};
+            std::shared_ptr<gapi::uniform_buffer> m_per_frame{nullptr};
+            std140_block<per_frame_layout> m_frame{};
+            std::vector<glm::mat4> m_views{};
+            uint32_t m_bound_view{0};
+            bool m_view_submitted{false};
+            // Submitted resources, kept alive until the frame's commands have been drawn.
+            std::vector<std::shared_ptr<const void>> m_retained{};
+
+            std::vector<indirect_draw> m_indirect{};
+            std::vector<draw_indirect_command> m_indirect_commands{};
+            std::vector<per_draw> m_indirect_data{};
+            std::shared_ptr<gapi::indirect_buffer> m_indirect_buffer{nullptr};
+            std::shared_ptr<gapi::storage_buffer> m_per_draw{nullptr};
+            std::vector<std::shared_ptr<gapi::framebuffer>> m_targets{};
 
     };
 
     using gl_renderer = gapi_render<ggl::api>;
+    using null_renderer = gapi_render<gnull::api>;
+
+    extern template class gapi_render<gnull::api>;
 }
 
-namespace gapir = gapi::renderer;
\ No newline at end of file
+namespace gapir = gapi::renderer;
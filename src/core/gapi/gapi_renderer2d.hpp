@@ -0,0 +1,249 @@
+#pragma once
+
+#include <array>
+#include "gapi_renderer.hpp"
+#include "gapi_texture_atlas.hpp"
+
+namespace gapi::renderer{
+
+    // 24 bytes: color is RGBA8 and texcoords are UNORM16, both normalized by the vertex fetch.
+    // texture_slot is -1 for flat color, a texture unit below max_texture_slots, or
+    // max_texture_slots plus a layer of the batch's texture array.
+    struct quad_vertex{
+        glm::vec3 position{0.0f};
+        uint32_t color{0xFFFFFFFF};
+        uint32_t texcoord{0};
+        int32_t texture_slot{-1};
+    };
+
+    static_assert(sizeof(quad_vertex) == 24, "quad_vertex must match its buffer_layout");
+
+    struct renderer2d_stats{
+        uint32_t quads{0};
+        uint32_t batches{0};
+        uint32_t flushes{0};
+    };
+
+    template<typename GApi>
+    class renderer2d {
+
+        public:
+            static constexpr uint32_t max_quads         = 10000;
+            static constexpr uint32_t max_vertices      = max_quads * 4;
+            static constexpr uint32_t max_indices       = max_quads * 6;
+            static constexpr uint32_t max_texture_slots = 32;
+            // Size of u_textures in renderer2d.glsl, the unit after them is the texture array's.
+            static constexpr uint32_t sampler_slots     = max_texture_slots - 1;
+            // Full batches one frame region holds; a frame drawing more waits for an older region.
+            static constexpr uint32_t batches_per_frame = 2;
+            static constexpr uint32_t frames_in_flight  = 3;
+            static constexpr int32_t  first_layer_slot  = static_cast<int32_t>(max_texture_slots);
+
+        public:
+            renderer2d(const std::shared_ptr<gapi_render<GApi>>& render, const std::shared_ptr<gapi::shader>& shader)
+                : m_render(render), m_shader(shader) {}
+            renderer2d(const renderer2d&) = delete;
+            renderer2d& operator=(const renderer2d&) = delete;
+            ~renderer2d() = default;
+
+            void init(){
+                std::vector<uint32_t> indices(max_indices);
+                for(uint32_t i = 0, v = 0; i < max_indices; i += 6, v += 4){
+                    indices[i + 0] = v + 0;
+                    indices[i + 1] = v + 1;
+                    indices[i + 2] = v + 2;
+                    indices[i + 3] = v + 2;
+                    indices[i + 4] = v + 3;
+                    indices[i + 5] = v + 0;
+                }
+
+                m_vertex_array = gapi_factory<GApi>::array();
+                m_vertex_array->bind();
+                m_vertex_buffer = gapi_factory<GApi>::stream_vertex(max_vertices * sizeof(quad_vertex) * batches_per_frame, frames_in_flight);
+                m_vertex_buffer->configure_layout({
+                    { "a_position",     XYZ,  ATTRIB_F32        },
+                    { "a_color",        RGBA, ATTRIB_U8,  true  },
+                    { "a_texcoord",     UV,   ATTRIB_U16, true  },
+                    { "a_texture_slot", X,    ATTRIB_I32        }
+                });
+                m_vertex_array->emplace_vertex(m_vertex_buffer);
+                m_vertex_array->emplace_index(gapi_factory<GApi>::static_index(indices.data(), indices.size()));
+                m_vertex_array->unbind();
+
+                // The last unit is kept for the texture array
+                const uint32_t units = m_render->max_texture_slots();
+                if(units < sampler_slots + 1) gapi_debug_msg("renderer2d.glsl needs 32 texture units, the driver reports ", units);
+                m_slot_count = std::min(std::max(units, 1u) - 1, sampler_slots);
+                std::array<int32_t, max_texture_slots> samplers{};
+                for(uint32_t i = 0; i < max_texture_slots; i++) samplers[i] = static_cast<int32_t>(i);
+
+                m_shader->bind();
+                m_shader->uniform("u_textures"_uniform, samplers.data(), m_slot_count);
+                m_shader->uniform("u_layers"_uniform, &samplers[m_slot_count], 1);
+            }
+
+            void begin_scene(){
+                m_stats = {};
+                m_vertex_buffer->begin_frame();
+                start_batch();
+            }
+
+            void begin_scene(const glm::mat4& projection_view){
+                m_render->camera(projection_view);
+                begin_scene();
+            }
+
+            void end_scene(){
+                flush();
+                m_vertex_buffer->end_frame();
+            }
+
+            void draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color){
+                emplace_quad(position, size, color, -1, {0.0f, 0.0f}, {1.0f, 1.0f});
+            }
+
+            void draw_quad(const glm::vec3& position, const glm::vec2& size, const std::shared_ptr<gapi::texture>& texture,
+                const glm::vec4& tint = glm::vec4(1.0f), const glm::vec2& uv_min = {0.0f, 0.0f}, const glm::vec2& uv_max = {1.0f, 1.0f}){
+                if(m_quad_count >= m_batch_quads) next_batch();
+                emplace_quad(position, size, tint, texture_slot(texture), uv_min, uv_max);
+            }
+
+            // Sprites from one atlas page share a texture slot, so they batch together.
+            void draw_quad(const glm::vec3& position, const glm::vec2& size, const atlas_region& region, const glm::vec4& tint = glm::vec4(1.0f)){
+                if(!region.valid()) return;
+                draw_quad(position, size, region.page, tint, region.uv_min, region.uv_max);
+            }
+
+            // Any layer of one array shares a single texture unit, so tiles and sprite sheets batch
+            // regardless of how many layers they use; switching arrays starts a new batch.
+            void draw_quad(const glm::vec3& position, const glm::vec2& size, const std::shared_ptr<gapi::texture_array>& array, uint32_t layer,
+                const glm::vec4& tint = glm::vec4(1.0f), const glm::vec2& uv_min = {0.0f, 0.0f}, const glm::vec2& uv_max = {1.0f, 1.0f}){
+                if(m_quad_count >= m_batch_quads) next_batch();
+                emplace_quad(position, size, tint, layer_slot(array, layer), uv_min, uv_max);
+            }
+
+            void draw_quad(const glm::mat4& transform, const glm::vec4& color){
+                emplace_quad(transform, color, -1);
+            }
+
+            void draw_quad(const glm::mat4& transform, const std::shared_ptr<gapi::texture>& texture, const glm::vec4& tint = glm::vec4(1.0f)){
+                if(m_quad_count >= m_batch_quads) next_batch();
+                emplace_quad(transform, tint, texture_slot(texture));
+            }
+
+            void draw_quad(const glm::mat4& transform, const std::shared_ptr<gapi::texture_array>& array, uint32_t layer, const glm::vec4& tint = glm::vec4(1.0f)){
+                if(m_quad_count >= m_batch_quads) next_batch();
+                emplace_quad(transform, tint, layer_slot(array, layer));
+            }
+
+            [[nodiscard]] const renderer2d_stats& stats() const { return m_stats; }
+
+        private:
+            // A batch takes at most what is left of the frame's region, so batches only move on to
+            // the next region, which may still be in flight, once this one is actually full.
+            void start_batch(){
+                constexpr uint32_t quad_size = 4 * sizeof(quad_vertex);
+                m_batch_quads = std::min(max_quads, m_vertex_buffer->remaining(sizeof(quad_vertex)) / quad_size);
+                if(m_batch_quads == 0) m_batch_quads = max_quads;
+                m_batch = m_vertex_buffer->reserve(m_batch_quads * quad_size, sizeof(quad_vertex));
+                m_write = static_cast<quad_vertex*>(m_batch.data);
+                m_quad_count = 0;
+                m_texture_count = 0;
+                m_array = nullptr;
+            }
+
+            void next_batch(){
+                flush();
+                start_batch();
+                m_stats.flushes++;
+            }
+
+            void flush(){
+                if(m_quad_count == 0) return;
+
+                TRIMANA_PROFILE_SCOPE("renderer2d::flush");
+                typename gapi_factory<GApi>::zone zone("renderer2d");
+                m_vertex_buffer->commit(m_quad_count * 4 * sizeof(quad_vertex));
+                for(uint32_t i = 0; i < m_texture_count; i++)
+                    m_textures[i]->bind(i);
+                if(m_array != nullptr) m_array->bind(m_slot_count);
+
+                m_shader->bind();
+                m_render->draw_immediate(m_vertex_array, m_quad_count * 6, m_batch.offset / sizeof(quad_vertex));
+                m_stats.batches++;
+            }
+
+            int32_t texture_slot(const std::shared_ptr<gapi::texture>& texture){
+                for(uint32_t i = 0; i < m_texture_count; i++){
+                    if(m_textures[i]->id() == texture->id())
+                        return static_cast<int32_t>(i);
+                }
+
+                if(m_texture_count >= m_slot_count) next_batch();
+                m_textures[m_texture_count] = texture;
+                return static_cast<int32_t>(m_texture_count++);
+            }
+
+            int32_t layer_slot(const std::shared_ptr<gapi::texture_array>& array, uint32_t layer){
+                if(m_array != nullptr && m_array->id() != array->id()) next_batch();
+                m_array = array;
+                return first_layer_slot + static_cast<int32_t>(layer);
+            }
+
+            void emplace_quad(const glm::vec3& p, const glm::vec2& s, const glm::vec4& color, int32_t slot, const glm::vec2& uv_min, const glm::vec2& uv_max){
+                if(m_quad_count >= m_batch_quads) next_batch();
+
+                const uint32_t c = glm::packUnorm4x8(color);
+                quad_vertex* v = m_write + m_quad_count * 4;
+                v[0] = { {p.x,       p.y,       p.z}, c, glm::packUnorm2x16({uv_min.x, uv_min.y}), slot };
+                v[1] = { {p.x + s.x, p.y,       p.z}, c, glm::packUnorm2x16({uv_max.x, uv_min.y}), slot };
+                v[2] = { {p.x + s.x, p.y + s.y, p.z}, c, glm::packUnorm2x16({uv_max.x, uv_max.y}), slot };
+                v[3] = { {p.x,       p.y + s.y, p.z}, c, glm::packUnorm2x16({uv_min.x, uv_max.y}), slot };
+
+                m_quad_count++;
+                m_stats.quads++;
+            }
+
+            void emplace_quad(const glm::mat4& transform, const glm::vec4& color, int32_t slot){
+                static const glm::vec4 corners[4] = {
+                    {-0.5f, -0.5f, 0.0f, 1.0f}, { 0.5f, -0.5f, 0.0f, 1.0f},
+                    { 0.5f,  0.5f, 0.0f, 1.0f}, {-0.5f,  0.5f, 0.0f, 1.0f}
+                };
+                static const uint32_t texcoords[4] = {
+                    glm::packUnorm2x16({0.0f, 0.0f}), glm::packUnorm2x16({1.0f, 0.0f}),
+                    glm::packUnorm2x16({1.0f, 1.0f}), glm::packUnorm2x16({0.0f, 1.0f})
+                };
+
+                if(m_quad_count >= m_batch_quads) next_batch();
+
+                const uint32_t c = glm::packUnorm4x8(color);
+                quad_vertex* v = m_write + m_quad_count * 4;
+                for(uint32_t i = 0; i < 4; i++){
+                    glm::vec4 p = transform * corners[i];
+                    v[i] = { {p.x, p.y, p.z}, c, texcoords[i], slot };
+                }
+
+                m_quad_count++;
+                m_stats.quads++;
+            }
+
+        private:
+            std::shared_ptr<gapi_render<GApi>> m_render{nullptr};
+            std::shared_ptr<gapi::shader> m_shader{nullptr};
+            std::shared_ptr<gapi::vertex_array> m_vertex_array{nullptr};
+            std::shared_ptr<gapi::stream_buffer> m_vertex_buffer{nullptr};
+
+            gapi::stream_allocation m_batch{};
+            quad_vertex* m_write{nullptr};
+            std::array<std::shared_ptr<gapi::texture>, max_texture_slots> m_textures{};
+            std::shared_ptr<gapi::texture_array> m_array{nullptr};
+            uint32_t m_quad_count{0};
+            uint32_t m_batch_quads{0};
+            uint32_t m_texture_count{0};
+            uint32_t m_slot_count{0};
+            renderer2d_stats m_stats{};
+    };
+
+    using gl_renderer2d = renderer2d<ggl::api>;
+    using null_renderer2d = renderer2d<gnull::api>;
+}
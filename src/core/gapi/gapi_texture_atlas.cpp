@@ -0,0 +1,216 @@
+#include "gapi_texture_atlas.hpp"
+
+#include <stb_image.h>
+
+// ImGui builds its own copy with STBRP_STATIC as well, so both stay private to their translation unit.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+namespace gapi::renderer{
+
+    struct texture_atlas::page{
+        stbrp_context context{};
+        std::vector<stbrp_node> nodes{};
+        std::vector<uint8_t> pixels{};
+        std::shared_ptr<gapi::texture> texture{nullptr};
+        int32_t dirty_min{0};
+        int32_t dirty_max{0};
+
+        void reset(int32_t size){
+            nodes.assign(size, stbrp_node{});
+            stbrp_init_target(&context, size, size, nodes.data(), size);
+            pixels.assign(static_cast<size_t>(size) * size * 4, 0);
+            dirty_min = 0;
+            dirty_max = size;
+        }
+
+        void upload(int32_t size){
+            if(dirty_min >= dirty_max) return;
+            texture->set_data(0, dirty_min, size, dirty_max - dirty_min, pixels.data() + static_cast<size_t>(dirty_min) * size * 4);
+            dirty_min = size;
+            dirty_max = 0;
+        }
+    };
+
+    texture_atlas::texture_atlas(texture_factory factory, int32_t page_size, int32_t padding)
+        : m_factory(std::move(factory)), m_page_size(page_size), m_padding(padding){
+        gapi_asserts(m_factory != nullptr, "Texture atlas needs a texture factory");
+    }
+
+    texture_atlas::~texture_atlas() = default;
+
+    uint32_t texture_atlas::add(const std::filesystem::path& path, bool flip){
+        int32_t width{0}, height{0}, channels{0};
+        stbi_set_flip_vertically_on_load(flip);
+        uint8_t* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
+        if(pixels == nullptr){
+            gapi_debug_msg("Failed to load atlas image: ", path.string());
+            m_images.push_back({0, 0, {}, {}, true});
+            return static_cast<uint32_t>(m_images.size() - 1);
+        }
+
+        uint32_t handle = add(width, height, pixels);
+        stbi_image_free(pixels);
+        return handle;
+    }
+
+    uint32_t texture_atlas::add(int32_t width, int32_t height, const uint8_t* rgba){
+        image entry{width, height};
+        entry.pixels.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+        m_images.push_back(std::move(entry));
+        return static_cast<uint32_t>(m_images.size() - 1);
+    }
+
+    void texture_atlas::pack(){
+        TRIMANA_PROFILE_SCOPE("texture_atlas::pack");
+        const int32_t largest = m_page_size - 2 * m_padding;
+        std::vector<uint32_t> queued;
+        for(uint32_t handle = 0; handle < m_images.size(); handle++){
+            image& entry = m_images[handle];
+            if(entry.placed) continue;
+            if(entry.width > largest || entry.height > largest){
+                gapi_debug_msg("Atlas image is larger than a page: ", std::to_string(entry.width) + "x" + std::to_string(entry.height));
+                entry.placed = true;
+                continue;
+            }
+            queued.push_back(handle);
+        }
+        if(queued.empty()) return;
+
+        place(queued);
+        if(queued.empty()){
+            flush();
+            return;
+        }
+
+        // Out of room: a fresh packing of everything may still fit the pages we already have.
+        // Images placed just now are in image_pixels already, only the rest are added, unpadded alike.
+        const texture_atlas_stats current = stats();
+        uint64_t queued_pixels = 0;
+        for(uint32_t handle : queued)
+            queued_pixels += static_cast<uint64_t>(m_images[handle].width) * m_images[handle].height;
+        if(current.pages > 0 && current.image_pixels + queued_pixels < repack_threshold * current.page_pixels){
+            repack();
+            return;
+        }
+
+        while(!queued.empty()){
+            emplace_page();
+            place(queued);
+        }
+        flush();
+    }
+
+    void texture_atlas::repack(){
+        TRIMANA_PROFILE_SCOPE("texture_atlas::repack");
+        std::vector<uint32_t> handles;
+        for(uint32_t handle = 0; handle < m_images.size(); handle++){
+            image& entry = m_images[handle];
+            if(entry.width == 0 || (entry.placed && !entry.region.valid())) continue;
+            entry.placed = false;
+            entry.region = {};
+            handles.push_back(handle);
+        }
+
+        std::stable_sort(handles.begin(), handles.end(), [this](uint32_t a, uint32_t b){
+            return m_images[a].height > m_images[b].height;
+        });
+
+        for(auto& target : m_pages) target->reset(m_page_size);
+        place(handles);
+        while(!handles.empty()){
+            emplace_page();
+            place(handles);
+        }
+
+        // Pages fill in order, so any left empty are at the back
+        while(!m_pages.empty()){
+            const auto& texture = m_pages.back()->texture;
+            if(std::any_of(m_images.begin(), m_images.end(), [&](const image& entry){ return entry.region.page == texture; })) break;
+            m_pages.pop_back();
+        }
+        flush();
+
+        m_generation++;
+        m_repacks++;
+    }
+
+    // Packs as many of the handles as fit into the existing pages, removing the ones placed.
+    void texture_atlas::place(std::vector<uint32_t>& handles){
+        std::vector<stbrp_rect> rects;
+        for(auto& target : m_pages){
+            if(handles.empty()) break;
+
+            rects.clear();
+            for(uint32_t handle : handles){
+                stbrp_rect rect{};
+                rect.id = static_cast<int>(handle);
+                rect.w = m_images[handle].width + 2 * m_padding;
+                rect.h = m_images[handle].height + 2 * m_padding;
+                rects.push_back(rect);
+            }
+            stbrp_pack_rects(&target->context, rects.data(), static_cast<int>(rects.size()));
+
+            handles.clear();
+            for(const auto& rect : rects){
+                if(rect.was_packed) blit(*target, m_images[rect.id], rect.x, rect.y);
+                else handles.push_back(static_cast<uint32_t>(rect.id));
+            }
+        }
+    }
+
+    // Pages are written once per pack() or repack(), after every image has been placed, since
+    // each write to a mipmapped page rebuilds its whole chain.
+    void texture_atlas::flush(){
+        for(auto& target : m_pages) target->upload(m_page_size);
+    }
+
+    // Copies the image inside its padding and extrudes its border into the padding, so linear
+    // filtering at the sprite's edge never samples a neighbour.
+    void texture_atlas::blit(page& target, image& source, int32_t x, int32_t y){
+        const int32_t width = source.width + 2 * m_padding;
+        const int32_t height = source.height + 2 * m_padding;
+        for(int32_t py = 0; py < height; py++){
+            const int32_t sy = std::clamp(py - m_padding, 0, source.height - 1);
+            uint8_t* row = target.pixels.data() + (static_cast<size_t>(y + py) * m_page_size + x) * 4;
+            for(int32_t px = 0; px < width; px++){
+                const int32_t sx = std::clamp(px - m_padding, 0, source.width - 1);
+                std::memcpy(row + px * 4, source.pixels.data() + (static_cast<size_t>(sy) * source.width + sx) * 4, 4);
+            }
+        }
+        target.dirty_min = std::min(target.dirty_min, y);
+        target.dirty_max = std::max(target.dirty_max, y + height);
+
+        const float size = static_cast<float>(m_page_size);
+        source.placed = true;
+        source.region.page = target.texture;
+        source.region.x = x + m_padding;
+        source.region.y = y + m_padding;
+        source.region.width = source.width;
+        source.region.height = source.height;
+        source.region.uv_min = {source.region.x / size, source.region.y / size};
+        source.region.uv_max = {(source.region.x + source.width) / size, (source.region.y + source.height) / size};
+    }
+
+    texture_atlas::page& texture_atlas::emplace_page(){
+        auto target = std::make_unique<page>();
+        target->texture = m_factory(m_page_size, m_page_size, 4);
+        target->reset(m_page_size);
+        m_pages.push_back(std::move(target));
+        return *m_pages.back();
+    }
+
+    texture_atlas_stats texture_atlas::stats() const{
+        texture_atlas_stats result{};
+        result.pages = static_cast<uint32_t>(m_pages.size());
+        result.repacks = m_repacks;
+        result.page_pixels = static_cast<uint64_t>(m_page_size) * m_page_size * m_pages.size();
+        for(const auto& entry : m_images){
+            if(!entry.region.valid()) continue;
+            result.images++;
+            result.image_pixels += static_cast<uint64_t>(entry.width) * entry.height;
+        }
+        return result;
+    }
+}
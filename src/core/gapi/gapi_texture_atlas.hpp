@@ -0,0 +1,85 @@
+#pragma once
+
+#include "gapi.hpp"
+
+namespace gapi::renderer{
+
+    // Where an atlas image ended up. UVs follow the flipped-on-load convention of texture_2d,
+    // so uv_min is the bottom left corner; both change when the atlas repacks.
+    struct atlas_region{
+        std::shared_ptr<gapi::texture> page{nullptr};
+        glm::vec2 uv_min{0.0f};
+        glm::vec2 uv_max{0.0f};
+        int32_t x{0};
+        int32_t y{0};
+        int32_t width{0};
+        int32_t height{0};
+
+        [[nodiscard]] inline bool valid() const { return page != nullptr; }
+    };
+
+    struct texture_atlas_stats{
+        uint32_t pages{0};
+        uint32_t images{0};
+        uint32_t repacks{0};
+        uint64_t image_pixels{0};
+        uint64_t page_pixels{0};
+
+        // Share of page area covered by images, padding counts as waste.
+        [[nodiscard]] inline float efficiency() const {
+            return page_pixels == 0 ? 0.0f : static_cast<float>(image_pixels) / static_cast<float>(page_pixels);
+        }
+    };
+
+    // Packs many small RGBA images into a few square pages with the skyline packer from
+    // imstb_rectpack, so sprites drawn through renderer2d share a texture slot and a batch.
+    //
+    // add() only queues an image and returns a stable handle; pack() places everything queued.
+    // New images go into the free space of existing pages first. When they would need another
+    // page while the existing ones are less than repack_threshold full, every image is repacked
+    // from scratch, tallest first, which recovers the space the skyline left behind.
+    class texture_atlas{
+
+        public:
+            static constexpr float repack_threshold = 0.8f;
+
+            texture_atlas(texture_factory factory, int32_t page_size = 1024, int32_t padding = 1);
+            texture_atlas(const texture_atlas&) = delete;
+            texture_atlas& operator=(const texture_atlas&) = delete;
+            ~texture_atlas();
+
+            [[nodiscard]] uint32_t add(const std::filesystem::path& path, bool flip = true);
+            [[nodiscard]] uint32_t add(int32_t width, int32_t height, const uint8_t* rgba);
+            void pack();
+            void repack();
+
+            [[nodiscard]] const atlas_region& region(uint32_t handle) const { return m_images[handle].region; }
+            [[nodiscard]] inline uint32_t generation() const { return m_generation; }
+            [[nodiscard]] texture_atlas_stats stats() const;
+
+        private:
+            struct image{
+                int32_t width{0};
+                int32_t height{0};
+                std::vector<uint8_t> pixels{};
+                atlas_region region{};
+                bool placed{false};
+            };
+
+            struct page;
+
+            void place(std::vector<uint32_t>& handles);
+            void flush();
+            void blit(page& target, image& source, int32_t x, int32_t y);
+            page& emplace_page();
+
+        private:
+            texture_factory m_factory{};
+            int32_t m_page_size{0};
+            int32_t m_padding{0};
+            std::vector<image> m_images{};
+            std::vector<std::unique_ptr<page>> m_pages{};
+            uint32_t m_generation{0};
+            uint32_t m_repacks{0};
+    };
+}
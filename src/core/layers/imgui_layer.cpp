@@ -331,6 +331,7 @@ namespace core::layers
 
     void imgui_layer::begin()
     {
+        TRIMANA_PROFILE_SCOPE("imgui_layer::begin");
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -340,9 +341,15 @@ namespace core::layers
 
     void imgui_layer::end()
     {
+        TRIMANA_PROFILE_SCOPE("imgui_layer::end");
         ImGui::EndFrame();
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            gapi::opengl::gpu_zone zone("imgui");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        // The backend restores the state it changes, but with raw GL calls the state cache never saw
+        gapi::opengl::state_cache::invalidate();
         // Update and Render additional Platform Windows
         // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
         //  For this specific demo app we could also call glfwMakeContextCurrent(window) directly)
@@ -12,6 +12,7 @@
 #include "events_keyboard.hpp"
 #include "events_mouse.hpp"
 #include "time_steps.hpp"
+#include "profiler.hpp"
 
 namespace core::layers
 {
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "platform_detection.hpp"
+#include "profiler.hpp"
 #include "events.hpp"
 #include "time_steps.hpp"
 
@@ -44,7 +45,7 @@ namespace core::layers
          * This constructor is used to create a layer object. The layer name is provided
          * as a parameter to uniquely identify the layer in the engine.
          */
-        layer(const std::string &name) : m_debug_name(name) {}
+        layer(const std::string &name) : m_debug_name(name), m_profile_name(core::profiling::profiler::intern(name)) {}
 
         /**
          * @brief Destructor.
@@ -103,11 +104,25 @@ namespace core::layers
          */
         const std::string &get_name() const { return m_debug_name; }
 
+        /**
+         * @brief Get the name the layer's profiler zones are recorded under.
+         *
+         * The constructor's name, interned once so recording a zone per frame
+         * takes no lock.
+         */
+        const char *get_profile_name() const { return m_profile_name; }
+
     protected:
         /**
          * @brief Store the name of the layer.
          */
         std::string m_debug_name{};
+
+    private:
+        /**
+         * @brief The interned name, valid until the program exits.
+         */
+        const char *m_profile_name{nullptr};
     };
 }
 #endif // __layer_h__
\ No newline at end of file
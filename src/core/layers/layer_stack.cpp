@@ -29,6 +29,7 @@ namespace core::layers
      */
     void layer_stack::pop_layer(sptr<layer> layer)
     {
+        TRIMANA_PROFILE_SCOPE("layer_stack::pop_layer");
         auto it = std::find(m_layers.begin(), m_layers.begin() + m_layer_insert_index, layer);
         if (it != m_layers.begin() + m_layer_insert_index)
         {
@@ -46,6 +47,7 @@ namespace core::layers
      */
     void layer_stack::pop_overlay(sptr<layer> layer)
     {
+        TRIMANA_PROFILE_SCOPE("layer_stack::pop_overlay");
         auto it = std::find(m_layers.begin() + m_layer_insert_index, m_layers.end(), layer);
         if (it != m_layers.end())
         {
@@ -6,6 +6,7 @@
 
 #ifndef __layer_h__
 #include "layer.hpp"
+#include "profiler.hpp"
 #endif
 
 namespace core::layers
@@ -0,0 +1,71 @@
+#include "profiler_layer.hpp"
+
+namespace core::layers
+{
+    profiler_layer::profiler_layer(uint32_t latency)
+        : layer("profiler_layer"), m_profiler(gapi::opengl::make_gpu_profiler(latency))
+    {
+    }
+
+    void profiler_layer::begin_frame()
+    {
+        m_profiler->begin_frame();
+    }
+
+    void profiler_layer::end_frame()
+    {
+        m_profiler->end_frame();
+    }
+
+    void profiler_layer::on_ui_updates()
+    {
+        ImGui::Begin("Profiler");
+        ImGui::Checkbox("Averages", &m_show_averages);
+        ImGui::SameLine();
+        ImGui::Text("Dropped frames: %u", m_profiler->dropped());
+
+        if (ImGui::BeginTable("zones", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("GPU ms");
+            ImGui::TableSetupColumn("CPU ms");
+            ImGui::TableHeadersRow();
+            for (const gapi::opengl::gpu_zone_stats &zone : m_profiler->zones())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%*s%s", static_cast<int>(zone.depth * 2), "", zone.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", m_show_averages ? zone.gpu_average_ms : zone.gpu_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", m_show_averages ? zone.cpu_average_ms : zone.cpu_ms);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Separator();
+        const core::profiling::profiler_stats cpu = core::profiling::profiler::stats();
+        if (!core::profiling::profiler::recording())
+        {
+            if (ImGui::Button("Record CPU trace"))
+                core::profiling::profiler::begin_session();
+            if (m_trace_written)
+            {
+                ImGui::SameLine();
+                ImGui::Text("Wrote %llu zones to %s", static_cast<unsigned long long>(cpu.events), m_trace_path.string().c_str());
+            }
+        }
+        else
+        {
+            if (ImGui::Button("Stop and save"))
+            {
+                core::profiling::profiler::end_session();
+                m_trace_written = core::profiling::profiler::write_chrome_trace(m_trace_path);
+            }
+            ImGui::SameLine();
+            ImGui::Text("%llu zones on %u threads, %llu dropped", static_cast<unsigned long long>(cpu.events), cpu.threads,
+                        static_cast<unsigned long long>(cpu.dropped));
+        }
+        ImGui::End();
+    }
+}
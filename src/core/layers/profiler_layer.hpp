@@ -0,0 +1,68 @@
+#ifndef __profiler_layer_h__
+#define __profiler_layer_h__
+
+#include <imgui.h>
+
+#include "layer.hpp"
+#include "profiler.hpp"
+#include "time_steps.hpp"
+#include "gapi_impl_opengl.hpp"
+
+namespace core::layers
+{
+    /**
+     * @class profiler_layer
+     * @brief Shows GPU and CPU times per named pass in an ImGui panel.
+     *
+     * The layer owns a `gapi::opengl::gpu_profiler`. The application brackets every frame with
+     * `begin_frame()` and `end_frame()`, and `gapi::opengl::gpu_zone` scopes opened in between,
+     * in layers, renderers or the ImGui layer, show up as rows of the panel. GPU times arrive a
+     * few frames late because the timer queries are read back without waiting.
+     *
+     * The panel also starts and stops CPU profiler sessions and writes each one as
+     * a Chrome trace when it stops.
+     */
+    class TRIMANA_API profiler_layer final : public layer
+    {
+    public:
+        /**
+         * @brief Constructs a `profiler_layer` object.
+         * @param latency The number of frames whose timer queries may be in flight.
+         */
+        profiler_layer(uint32_t latency = 4);
+
+        /**
+         * @brief Default destructor.
+         */
+        virtual ~profiler_layer() = default;
+
+        /**
+         * @brief Called every frame to draw the profiler panel.
+         */
+        virtual void on_ui_updates() override;
+
+        /**
+         * @brief Starts timing a frame, collecting the results of earlier frames that are ready.
+         */
+        void begin_frame();
+
+        /**
+         * @brief Stops timing the current frame.
+         */
+        void end_frame();
+
+        /**
+         * @brief Gets the profiler the panel reads from.
+         * @return The GPU profiler.
+         */
+        const sptr<gapi::opengl::gpu_profiler> &profiler() const { return m_profiler; }
+
+    private:
+        sptr<gapi::opengl::gpu_profiler> m_profiler{nullptr}; /**< The profiler timing each frame. */
+        bool m_show_averages{true}; /**< Whether the panel shows moving averages or the latest frame. */
+        std::filesystem::path m_trace_path{"trace.json"}; /**< Where CPU sessions are written. */
+        bool m_trace_written{false}; /**< Whether the last CPU session was written. */
+    };
+}
+
+#endif // __profiler_layer_h__
@@ -0,0 +1,170 @@
+#include "file_watcher.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+
+#if defined(TRIMANA_PLATFORM_LINUX)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace core::files
+{
+#if defined(TRIMANA_PLATFORM_LINUX)
+    /**
+     * @brief Events that mean a file now holds new contents.
+     *
+     * IN_CLOSE_WRITE covers in-place saves, IN_MOVED_TO covers editors that save
+     * through a temporary file, IN_CREATE picks up new files and directories.
+     */
+    static constexpr uint32_t s_watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    /**
+     * @brief How long the watch thread sleeps before checking whether it should stop.
+     */
+    static constexpr int s_poll_timeout_ms = 100;
+
+    file_watcher::file_watcher()
+    {
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0)
+        {
+            TRIMANA_CORE_WARN("File watcher unavailable, inotify_init1 failed");
+            return;
+        }
+
+        m_running = true;
+        m_thread = std::thread(&file_watcher::run, this);
+    }
+
+    file_watcher::~file_watcher()
+    {
+        m_running = false;
+        if (m_thread.joinable())
+            m_thread.join();
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+
+    bool file_watcher::watch(const std::filesystem::path &directory, bool recursive)
+    {
+        if (m_fd < 0)
+            return false;
+
+        std::error_code error;
+        std::filesystem::path root = std::filesystem::weakly_canonical(directory, error);
+        if (error || !std::filesystem::is_directory(root, error))
+        {
+            TRIMANA_CORE_WARN("File watcher: {} is not a directory", directory.string());
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!add(root))
+            return false;
+
+        if (recursive)
+        {
+            m_recursive.push_back(root);
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(root, error))
+                if (entry.is_directory(error))
+                    add(entry.path());
+        }
+
+        return true;
+    }
+
+    bool file_watcher::add(const std::filesystem::path &directory)
+    {
+        int descriptor = inotify_add_watch(m_fd, directory.c_str(), s_watch_mask);
+        if (descriptor < 0)
+        {
+            TRIMANA_CORE_WARN("File watcher: failed to watch {}", directory.string());
+            return false;
+        }
+
+        m_directories[descriptor] = directory;
+        return true;
+    }
+
+    std::vector<std::filesystem::path> file_watcher::poll()
+    {
+        std::vector<std::filesystem::path> changes;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        changes.swap(m_changes);
+        return changes;
+    }
+
+    void file_watcher::run()
+    {
+        // Large enough for many events at once, aligned as inotify requires.
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd descriptor{m_fd, POLLIN, 0};
+
+        while (m_running)
+        {
+            if (::poll(&descriptor, 1, s_poll_timeout_ms) <= 0)
+                continue;
+
+            ssize_t length = read(m_fd, buffer, sizeof(buffer));
+            if (length <= 0)
+                continue;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (char *cursor = buffer; cursor < buffer + length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_IGNORED)
+                {
+                    m_directories.erase(event->wd);
+                    continue;
+                }
+
+                auto directory = m_directories.find(event->wd);
+                if (directory == m_directories.end() || event->len == 0)
+                    continue;
+
+                std::filesystem::path path = directory->second / event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    // New sub directories of a recursive watch are watched too.
+                    bool recursive = std::any_of(m_recursive.begin(), m_recursive.end(), [&](const std::filesystem::path &root) {
+                        return std::mismatch(root.begin(), root.end(), path.begin(), path.end()).first == root.end();
+                    });
+                    if (recursive && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                        add(path);
+                    continue;
+                }
+
+                if (std::find(m_changes.begin(), m_changes.end(), path) == m_changes.end())
+                    m_changes.push_back(std::move(path));
+            }
+        }
+    }
+#else
+    file_watcher::file_watcher() {}
+
+    file_watcher::~file_watcher() {}
+
+    bool file_watcher::watch(const std::filesystem::path &directory, bool recursive)
+    {
+        TRIMANA_CORE_WARN("File watcher is not supported on this platform, {} is not watched", directory.string());
+        return false;
+    }
+
+    std::vector<std::filesystem::path> file_watcher::poll()
+    {
+        return {};
+    }
+
+    void file_watcher::run() {}
+
+    bool file_watcher::add(const std::filesystem::path &directory)
+    {
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,123 @@
+#ifndef __file_watcher_h__
+#define __file_watcher_h__
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "platform_detection.hpp"
+
+namespace core::files
+{
+    /**
+     * @brief Watches directories for modified files on a background thread.
+     *
+     * The watcher owns one inotify instance (Linux) and a thread that sleeps on it.
+     * Whenever a file below a watched directory is written and closed, moved in or
+     * created, its canonical path is queued. The main loop collects the queue with
+     * `poll()`, which never waits for the filesystem, so it can be called once per
+     * frame at no measurable cost.
+     *
+     * Editors frequently save through a temporary file followed by a rename, and
+     * may fire several events for one save. Every path is therefore reported at
+     * most once per `poll()`, regardless of how many events it produced.
+     *
+     * On platforms without inotify the watcher stays inactive and `watch()`
+     * returns false, so callers do not need platform checks of their own.
+     */
+    class TRIMANA_API file_watcher
+    {
+    public:
+        /**
+         * @brief Creates the inotify instance and starts the watch thread.
+         */
+        file_watcher();
+
+        /**
+         * @brief Stops the watch thread and releases every watch.
+         */
+        ~file_watcher();
+
+        file_watcher(const file_watcher &) = delete;
+        file_watcher &operator=(const file_watcher &) = delete;
+
+        /**
+         * @brief Starts watching a directory.
+         *
+         * @param directory The directory to watch, relative paths resolve against
+         *                  the working directory.
+         * @param recursive Also watch every sub directory, including ones created
+         *                  after this call.
+         * @return true if the directory is now watched.
+         */
+        bool watch(const std::filesystem::path &directory, bool recursive = true);
+
+        /**
+         * @brief Returns the files modified since the previous call.
+         *
+         * The paths are canonical and unique. This call only swaps a queue under a
+         * lock and never blocks on the filesystem.
+         *
+         * @return The modified files, empty when nothing changed.
+         */
+        std::vector<std::filesystem::path> poll();
+
+        /**
+         * @brief Returns true if the platform supports watching and the watch
+         *        thread is running.
+         */
+        bool active() const { return m_running; }
+
+    private:
+        /**
+         * @brief Body of the watch thread, drains inotify until the watcher stops.
+         */
+        void run();
+
+        /**
+         * @brief Adds a single directory watch, the caller holds `m_mutex`.
+         */
+        bool add(const std::filesystem::path &directory);
+
+    private:
+        /**
+         * @brief The inotify file descriptor, -1 when watching is unavailable.
+         */
+        int m_fd{-1};
+
+        /**
+         * @brief Watch descriptors mapped to the directory they observe.
+         */
+        std::unordered_map<int, std::filesystem::path> m_directories;
+
+        /**
+         * @brief Directories whose new sub directories are watched as well.
+         */
+        std::vector<std::filesystem::path> m_recursive;
+
+        /**
+         * @brief Modified files not yet returned by `poll()`.
+         */
+        std::vector<std::filesystem::path> m_changes;
+
+        /**
+         * @brief Guards the watch maps and the change queue.
+         */
+        std::mutex m_mutex;
+
+        /**
+         * @brief Cleared to make the watch thread exit.
+         */
+        std::atomic<bool> m_running{false};
+
+        /**
+         * @brief The watch thread.
+         */
+        std::thread m_thread;
+    };
+}
+
+#endif // __file_watcher_h__
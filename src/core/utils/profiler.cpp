@@ -0,0 +1,216 @@
+#include "profiler.hpp"
+
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace core::profiling
+{
+    /**
+     * @brief Single producer, single consumer ring of one thread's zones.
+     *
+     * Only the owning thread advances `head` and only `collect()` advances
+     * `tail`, so neither side needs a lock.
+     */
+    struct thread_ring
+    {
+        std::array<zone_event, profiler::ring_capacity> events{};
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        uint32_t id{0};
+        std::string name{};
+    };
+
+    struct session_event
+    {
+        zone_event zone{};
+        uint32_t thread{0};
+    };
+
+    /**
+     * @brief Rings of every thread that recorded a zone, and the collected session.
+     *
+     * Rings are shared so a thread that exits keeps its unread events.
+     */
+    struct profiler_state
+    {
+        std::mutex mutex{};
+        std::vector<std::shared_ptr<thread_ring>> rings{};
+        std::vector<session_event> events{};
+        int64_t epoch{0};
+    };
+
+    static profiler_state &state()
+    {
+        static profiler_state instance{};
+        return instance;
+    }
+
+    /**
+     * @brief Zone names copied by `profiler::intern()`.
+     *
+     * Nodes of a set never move, so the returned pointers stay valid while
+     * further names are added. Names are never removed.
+     */
+    struct name_table
+    {
+        std::mutex mutex{};
+        std::set<std::string, std::less<>> names{};
+    };
+
+    static name_table &names()
+    {
+        static name_table instance{};
+        return instance;
+    }
+
+    static thread_local thread_ring *t_ring = nullptr;
+
+    static thread_ring &local_ring()
+    {
+        if (t_ring == nullptr)
+        {
+            auto ring = std::make_shared<thread_ring>();
+            profiler_state &shared = state();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            ring->id = static_cast<uint32_t>(shared.rings.size());
+            ring->name = "thread " + std::to_string(ring->id);
+            shared.rings.push_back(ring);
+            t_ring = ring.get();
+        }
+        return *t_ring;
+    }
+
+    static void write_string(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (const char *c = text; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                out << *c;
+        }
+        out << '"';
+    }
+
+    void profiler::begin_session()
+    {
+        profiler_state &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (auto &ring : shared.rings)
+        {
+            ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            ring->dropped.store(0, std::memory_order_relaxed);
+        }
+        shared.events.clear();
+        shared.epoch = now();
+        s_recording.store(true, std::memory_order_relaxed);
+    }
+
+    void profiler::end_session()
+    {
+        s_recording.store(false, std::memory_order_relaxed);
+        collect();
+    }
+
+    void profiler::collect()
+    {
+        profiler_state &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (auto &ring : shared.rings)
+        {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail < head; tail++)
+                shared.events.push_back({ring->events[tail & (ring_capacity - 1)], ring->id});
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    void profiler::record(const char *name, int64_t start, int64_t end)
+    {
+        thread_ring &ring = local_ring();
+        const uint64_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= ring_capacity)
+        {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.events[head & (ring_capacity - 1)] = {name, start, end};
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    const char *profiler::intern(std::string_view name)
+    {
+        name_table &table = names();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto it = table.names.find(name);
+        if (it == table.names.end())
+            it = table.names.emplace(name).first;
+        return it->c_str();
+    }
+
+    void profiler::thread_name(const std::string &name)
+    {
+        thread_ring &ring = local_ring();
+        std::lock_guard<std::mutex> lock(state().mutex);
+        ring.name = name;
+    }
+
+    profiler_stats profiler::stats()
+    {
+        profiler_state &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        profiler_stats result{};
+        result.events = shared.events.size();
+        result.threads = static_cast<uint32_t>(shared.rings.size());
+        for (const auto &ring : shared.rings)
+            result.dropped += ring->dropped.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /**
+     * Every zone becomes a complete ("X") event with microsecond times relative to
+     * the start of the session, each thread a named track of process 0.
+     */
+    bool profiler::write_chrome_trace(const std::filesystem::path &path)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        profiler_state &shared = state();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        for (const auto &ring : shared.rings)
+        {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->id << ",\"args\":{\"name\":";
+            write_string(out, ring->name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        for (const session_event &event : shared.events)
+        {
+            if (event.zone.start < shared.epoch)
+                continue;
+            out << (first ? "" : ",") << "\n{\"name\":";
+            write_string(out, event.zone.name);
+            out << ",\"cat\":\"trimana\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+                << ",\"ts\":" << (event.zone.start - shared.epoch) / 1000.0
+                << ",\"dur\":" << (event.zone.end - event.zone.start) / 1000.0 << "}";
+            first = false;
+        }
+
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+}
@@ -0,0 +1,180 @@
+#ifndef __profiler_h__
+#define __profiler_h__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "platform_detection.hpp"
+
+namespace core::profiling
+{
+    /**
+     * @brief One finished zone as recorded by the thread that ran it.
+     *
+     * Times are nanoseconds of the steady clock. The name is not copied, so it
+     * must stay valid until the session has been written: string literals,
+     * `__func__` or a name returned by `profiler::intern()`.
+     */
+    struct zone_event
+    {
+        const char *name{nullptr};
+        int64_t start{0};
+        int64_t end{0};
+    };
+
+    /**
+     * @brief Counters of the current or last session.
+     */
+    struct profiler_stats
+    {
+        uint64_t events{0};  /**< Zones collected into the session. */
+        uint64_t dropped{0}; /**< Zones lost because a thread's ring was full. */
+        uint32_t threads{0}; /**< Threads that have recorded at least one zone. */
+    };
+
+    /**
+     * @brief Records CPU zones from any thread into a session that can be
+     *        written as a Chrome trace.
+     *
+     * Every thread records into a ring buffer of its own, created on its first
+     * zone. The owning thread is the only writer and `collect()` the only reader,
+     * so recording takes no lock: a zone costs two clock reads and a store. When a
+     * ring is full because `collect()` has not run for a while, further zones of
+     * that thread are dropped and counted rather than blocking the thread.
+     *
+     * The application calls `collect()` once per frame, which moves every ring's
+     * events into the session. `write_chrome_trace()` writes them in the JSON
+     * trace event format read by chrome://tracing and Perfetto. Zones are only
+     * recorded between `begin_session()` and `end_session()`; outside a session
+     * a zone costs one relaxed atomic load.
+     */
+    class TRIMANA_API profiler
+    {
+    public:
+        static constexpr uint32_t ring_capacity = 1 << 14;
+
+        /**
+         * @brief Clears the previous session and starts recording.
+         */
+        static void begin_session();
+
+        /**
+         * @brief Stops recording and collects what the rings still hold.
+         */
+        static void end_session();
+
+        /**
+         * @brief Returns true while a session is recording.
+         */
+        static bool recording() { return s_recording.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Moves the events of every thread's ring into the session.
+         *
+         * Call it once per frame from one thread; it never waits for recording
+         * threads.
+         */
+        static void collect();
+
+        /**
+         * @brief Writes the collected session as Chrome trace event JSON.
+         *
+         * @param path The file to write, replaced if it exists.
+         * @return true if the file was written.
+         */
+        static bool write_chrome_trace(const std::filesystem::path &path);
+
+        /**
+         * @brief Names the calling thread in written traces.
+         *
+         * @param name The thread name, "thread N" is used for unnamed threads.
+         */
+        static void thread_name(const std::string &name);
+
+        /**
+         * @brief Returns the counters of the current or last session.
+         */
+        static profiler_stats stats();
+
+        /**
+         * @brief Records one finished zone on the calling thread.
+         *
+         * @param name The zone name, see `zone_event` for its lifetime.
+         * @param start The zone's start, from `now()`.
+         * @param end The zone's end, from `now()`.
+         */
+        static void record(const char *name, int64_t start, int64_t end);
+
+        /**
+         * @brief Returns a copy of the name that lives as long as the program.
+         *
+         * Names built at run time, such as a layer's name, go through here once,
+         * when their owner is created, and the returned pointer is what zones
+         * record. Equal names share one copy. It takes a lock, so keep it off
+         * per-frame paths.
+         *
+         * @param name The zone name to copy.
+         * @return The interned name, valid until the program exits.
+         */
+        static const char *intern(std::string_view name);
+
+        /**
+         * @brief Returns the steady clock in nanoseconds.
+         */
+        static int64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        inline static std::atomic<bool> s_recording{false}; /**< Whether zones are recorded. */
+    };
+
+    /**
+     * @brief Records the enclosing scope as a zone when a session is recording.
+     *
+     * Use it through `TRIMANA_PROFILE_SCOPE` and `TRIMANA_PROFILE_FUNCTION` so
+     * builds without `TRIMANA_PROFILE_ENABLED` compile zones away entirely.
+     */
+    class scoped_zone
+    {
+    public:
+        explicit scoped_zone(const char *name)
+            : m_name(profiler::recording() ? name : nullptr), m_start(m_name != nullptr ? profiler::now() : 0) {}
+
+        ~scoped_zone()
+        {
+            if (m_name != nullptr)
+                profiler::record(m_name, m_start, profiler::now());
+        }
+
+        scoped_zone(const scoped_zone &) = delete;
+        scoped_zone &operator=(const scoped_zone &) = delete;
+
+    private:
+        const char *m_name{nullptr}; /**< The zone name, null when not recording. */
+        int64_t m_start{0};          /**< The steady clock when the scope was entered. */
+    };
+}
+
+#define TRIMANA_PROFILE_CONCAT_INNER(a, b) a##b
+#define TRIMANA_PROFILE_CONCAT(a, b) TRIMANA_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef TRIMANA_PROFILE_ENABLED
+// Records the rest of the enclosing scope under the given name.
+#define TRIMANA_PROFILE_SCOPE(name) ::core::profiling::scoped_zone TRIMANA_PROFILE_CONCAT(trimana_profile_zone_, __LINE__)(name)
+// Records the rest of the enclosing function under its name.
+#define TRIMANA_PROFILE_FUNCTION() TRIMANA_PROFILE_SCOPE(__func__)
+// Names the calling thread's track in written traces.
+#define TRIMANA_PROFILE_THREAD(name) ::core::profiling::profiler::thread_name(name)
+#else
+#define TRIMANA_PROFILE_SCOPE(name)
+#define TRIMANA_PROFILE_FUNCTION()
+#define TRIMANA_PROFILE_THREAD(name)
+#endif
+
+#endif // __profiler_h__
@@ -0,0 +1,114 @@
+#include <gapi/gapi_compressed_texture.hpp>
+
+#include "test.hpp"
+
+using namespace gapi;
+
+static bool texel(const std::vector<uint8_t>& rgba, size_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+    return rgba.size() >= (index + 1) * 4 && rgba[index * 4] == r && rgba[index * 4 + 1] == g && rgba[index * 4 + 2] == b && rgba[index * 4 + 3] == a;
+}
+
+static void put(std::vector<uint8_t>& file, size_t offset, uint64_t value, size_t bytes){
+    if(file.size() < offset + bytes) file.resize(offset + bytes);
+    std::memcpy(file.data() + offset, &value, bytes);
+}
+
+static bool load(const std::vector<uint8_t>& file, compressed_image& image){
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "trimana_compressed_texture_test";
+    std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(file.data()), file.size());
+    const bool loaded = load_compressed(path, image);
+    std::filesystem::remove(path);
+    return loaded;
+}
+
+// Red and blue RGB565 endpoints with c0 > c1, so four colors; texels 0-3 use indices 0, 1, 2 and 3.
+static constexpr uint8_t s_color_block[8] = {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0x00, 0x00, 0x00};
+
+static void decode_bc1(){
+    std::vector<uint8_t> rgba;
+    check(decode_blocks(BLOCK_BC1, s_color_block, 4, 4, rgba));
+    check(rgba.size() == 4 * 4 * 4);
+    check(texel(rgba, 0, 255, 0, 0, 255));
+    check(texel(rgba, 1, 0, 0, 255, 255));
+    check(texel(rgba, 2, 170, 0, 85, 255));
+    check(texel(rgba, 3, 85, 0, 170, 255));
+    check(texel(rgba, 15, 255, 0, 0, 255));
+
+    // c0 <= c1 selects three colors, index 3 is transparent black for BC1A and opaque black for BC1
+    const uint8_t punch_through[8] = {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0x00, 0x00, 0x00};
+    check(decode_blocks(BLOCK_BC1A, punch_through, 4, 4, rgba));
+    check(texel(rgba, 2, 127, 0, 127, 255));
+    check(texel(rgba, 3, 0, 0, 0, 0));
+    check(decode_blocks(BLOCK_BC1, punch_through, 4, 4, rgba));
+    check(texel(rgba, 3, 0, 0, 0, 255));
+
+    // Texels outside a 2x2 level are dropped
+    check(decode_blocks(BLOCK_BC1, s_color_block, 2, 2, rgba));
+    check(rgba.size() == 2 * 2 * 4);
+    check(texel(rgba, 1, 0, 0, 255, 255));
+    check(texel(rgba, 2, 255, 0, 0, 255));
+}
+
+static void decode_bc3(){
+    // Alpha endpoints 255 and 0 give eight values; texels 0-2 use alpha indices 0, 1 and 2
+    uint8_t block[16] = {255, 0, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00};
+    std::memcpy(block + 8, s_color_block, sizeof(s_color_block));
+
+    std::vector<uint8_t> rgba;
+    check(decode_blocks(BLOCK_BC3, block, 4, 4, rgba));
+    check(texel(rgba, 0, 255, 0, 0, 255));
+    check(texel(rgba, 1, 0, 0, 255, 0));
+    check(texel(rgba, 2, 170, 0, 85, 218));
+    check(texel(rgba, 3, 85, 0, 170, 255));
+    check(!decode_blocks(BLOCK_BC7, block, 4, 4, rgba));
+}
+
+static std::vector<uint8_t> dds(uint32_t width, uint32_t height){
+    std::vector<uint8_t> file(128, 0);
+    std::memcpy(file.data(), "DDS ", 4);
+    put(file, 4, 124, 4);
+    put(file, 12, height, 4);
+    put(file, 16, width, 4);
+    std::memcpy(file.data() + 84, "DXT1", 4);
+    file.insert(file.end(), s_color_block, s_color_block + sizeof(s_color_block));
+    return file;
+}
+
+static std::vector<uint8_t> ktx2(uint64_t offset, uint64_t size){
+    static constexpr uint8_t magic[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> file(magic, magic + sizeof(magic));
+    put(file, 12, 131, 4);
+    put(file, 20, 4, 4);
+    put(file, 24, 4, 4);
+    put(file, 36, 1, 4);
+    put(file, 40, 1, 4);
+    put(file, 80, offset, 8);
+    put(file, 88, size, 8);
+    put(file, 96, size, 8);
+    file.insert(file.end(), s_color_block, s_color_block + sizeof(s_color_block));
+    return file;
+}
+
+static void container_bounds(){
+    compressed_image image;
+    check(load(dds(4, 4), image));
+    check(image.levels.size() == 1 && image.levels[0].size == 8);
+    check(!load(dds(0, 4), image));
+    check(!load(dds(0xFFFFFFFF, 4), image));
+    check(!load(dds(4, max_block_dimension + 1), image));
+    // The only level is larger than the file
+    check(!load(dds(8, 8), image));
+
+    check(load(ktx2(104, 8), image));
+    check(image.levels.size() == 1 && image.levels[0].offset == 104);
+    check(!load(ktx2(104, 9), image));
+    // offset + size wraps around to a small value
+    check(!load(ktx2(~uint64_t{0} - 3, 8), image));
+}
+
+int main(){
+    decode_bc1();
+    decode_bc3();
+    container_bounds();
+    return finish("gapi_compressed_texture");
+}
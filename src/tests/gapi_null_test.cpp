@@ -0,0 +1,139 @@
+#include <gapi/gapi_renderer2d.hpp>
+
+#include "test.hpp"
+
+using namespace gapi;
+using namespace gapi::renderer;
+
+// Every resource counts as alive until its last owner drops it.
+static void resources(){
+    const int64_t alive = gnull::stats().resources_alive;
+    {
+        auto vertices = gnull::make_vertex(256);
+        auto indices = gnull::make_index(static_cast<uint32_t*>(nullptr), 6);
+        auto texture = gnull::make_texture2d(4, 4, 4);
+        check(gnull::stats().resources_alive == alive + 3);
+    }
+    check(gnull::stats().resources_alive == alive);
+}
+
+// Updates bind the buffer like the OpenGL backend does, and only growth allocates.
+static void buffers(){
+    auto uniforms = gnull::make_uniform(64, 0);
+    auto storage = gnull::make_storage(64, 1);
+    const std::array<std::byte, 128> data{};
+
+    gnull::reset_stats();
+    uniforms->set_data(data.data(), 64);
+    check(gnull::stats().binds == 1);
+    check(gnull::stats().bytes_uploaded == 64);
+
+    gnull::reset_stats();
+    storage->set_data(data.data(), 32);
+    check(gnull::stats().buffer_allocations == 0);
+    check(gnull::stats().buffer_orphans == 1);
+    storage->set_data(data.data(), 64 + 1);
+    check(gnull::stats().buffer_allocations == 1);
+}
+
+// A 1 MB buffer updated every frame keeps its store: partial writes and orphaning never reallocate.
+static void frame_updates(){
+    constexpr uint32_t size = 1024 * 1024;
+    constexpr uint32_t frames = 600;
+    auto vertices = gnull::make_vertex(size);
+    auto indices = gnull::make_index(static_cast<uint32_t*>(nullptr), size / sizeof(uint32_t));
+    const std::vector<std::byte> vertex_data(size);
+    const std::vector<uint32_t> index_data(size / sizeof(uint32_t));
+
+    gnull::reset_stats();
+    for(uint32_t frame = 0; frame < frames; frame++){
+        vertices->set_data(0, vertex_data);
+        indices->set_data(0, index_data);
+    }
+    check(gnull::stats().buffer_allocations == 0);
+    check(gnull::stats().buffer_orphans == 0);
+    check(gnull::stats().bytes_uploaded == uint64_t{2} * size * frames);
+
+    gnull::reset_stats();
+    for(uint32_t frame = 0; frame < frames; frame++){
+        vertices->orphan(vertex_data);
+        indices->orphan(index_data);
+    }
+    check(gnull::stats().buffer_allocations == 0);
+    check(gnull::stats().buffer_orphans == 2 * frames);
+    check(indices->count() == index_data.size());
+
+    // Only a new size allocates
+    gnull::reset_stats();
+    vertices->resize(size * 2);
+    indices->resize(size / sizeof(uint32_t) * 2);
+    vertices->resize(size * 2);
+    check(gnull::stats().buffer_allocations == 2);
+}
+
+// A variant is built once per set of defines, whatever order they were given in, and named after them.
+static void variants(){
+    shader_container shaders(gnull::make_shader_factory());
+    shaders.emplace_source("main", "main.glsl");
+    auto plain = shaders.variant("main");
+    auto textured = shaders.variant("main", {{"TEXTURED", "1"}, {"LIGHTS", "4"}});
+    check(shaders.variant("main", {{"LIGHTS", "4"}, {"TEXTURED", "1"}}) == textured);
+    check(shaders.variant("main", {{"TEXTURED", "1"}, {"LIGHTS", "2"}}) != textured);
+    check(shaders.variant("main") == plain);
+    check(shaders.variants() == 3);
+    check(plain->name() == "main");
+    check(textured->name() == "main[LIGHTS=4,TEXTURED=1]");
+}
+
+// The queue draws every submission once and sorts it so consecutive draws share state.
+static void sorted_queue(){
+    auto render = std::make_shared<null_renderer>();
+    render->init();
+    auto first = gnull::make_shader("first");
+    auto second = gnull::make_shader("second");
+    auto va = gnull::make_array();
+    uint32_t indices[3]{0, 1, 2};
+    va->emplace_index(gnull::make_index(indices, 3));
+
+    gnull::reset_stats();
+    render->begin_frame();
+    for(uint32_t i = 0; i < 10; i++) render->submit(i % 2 ? first : second, va);
+    render->end_frame();
+    check(gnull::stats().draws == 10);
+    check(render->queue_stats().avoided_state_changes() > 0);
+}
+
+// More textures than units and more quads than a batch holds, drawn without allocating.
+static void batches(){
+    auto render = std::make_shared<null_renderer>();
+    render->init();
+    null_renderer2d quads(render, gnull::make_shader("quads"));
+    quads.init();
+
+    std::vector<std::shared_ptr<gapi::texture>> textures;
+    for(uint32_t i = 0; i < 40; i++) textures.push_back(gnull::make_texture2d(4, 4, 4));
+
+    gnull::reset_stats();
+    for(uint32_t frame = 0; frame < 4; frame++){
+        quads.begin_scene(glm::mat4(1.0f));
+        for(uint32_t i = 0; i < 25000; i++){
+            if(i % 2) quads.draw_quad({0.0f, 0.0f, 0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f});
+            else quads.draw_quad({0.0f, 0.0f, 0.0f}, {1.0f, 1.0f}, textures[i % textures.size()]);
+        }
+        quads.end_scene();
+        check(quads.stats().quads == 25000);
+        check(quads.stats().batches > 1);
+    }
+    check(gnull::stats().draws > 0);
+    check(gnull::stats().buffer_allocations == 0);
+}
+
+int main(){
+    resources();
+    buffers();
+    frame_updates();
+    variants();
+    sorted_queue();
+    batches();
+    return finish("gapi_null");
+}
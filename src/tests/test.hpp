@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks keep going after a failure so one run reports all of them; main returns finish().
+inline int s_failures = 0;
+
+#define check(exp) if(!(exp)) { std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #exp); s_failures++; }
+
+inline int finish(const char* name){
+    if(s_failures == 0) std::printf("%s: all checks passed\n", name);
+    return s_failures == 0 ? 0 : 1;
+}